@@ -0,0 +1,106 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/sys.h"
+#include "rtps/config.h"
+#include "rtps/storages/SampleHandle.h"
+#include "rtps/utils/Lock.h"
+
+#include <array>
+#include <atomic>
+
+namespace rtps {
+
+class Reader;
+class ReaderCacheChange;
+
+/**
+ * Runs reader callbacks registered as CallbackMode::DEFERRED on worker
+ * threads instead of the receive thread. Each worker owns a single-producer
+ * single-consumer ring, the consumer side is lock-free. All callbacks of a
+ * reader go to the same worker, so their order is preserved.
+ *
+ * Samples are kept alive with a SampleHandle until the callback ran. A job
+ * is dropped if the ring is full or the sample cannot be retained.
+ */
+class CallbackExecutor {
+public:
+  //! Bucket 0 counts 0, bucket i counts values in [2^(i-1), 2^i), the last
+  //! one everything above
+  using Histogram =
+      std::array<uint32_t, Config::CALLBACK_EXECUTOR_HISTOGRAM_BUCKETS>;
+
+  CallbackExecutor() = default;
+  ~CallbackExecutor();
+  CallbackExecutor(const CallbackExecutor &other) = delete;
+  CallbackExecutor &operator=(const CallbackExecutor &other) = delete;
+
+  //! Returns false if not all workers could be created, callbacks then
+  //! have to run inline
+  bool start();
+  void stop();
+  bool isRunning() const { return m_running; }
+
+  //! Called by the receive thread. Returns false if the job was dropped.
+  bool dispatch(Reader &reader, uint32_t callbackIdentifier,
+                const ReaderCacheChange &cacheChange);
+
+  //! Jobs queued at the worker when a new one arrives
+  Histogram getQueueDepthHistogram() const;
+  //! Execution time of callbacks in ms
+  Histogram getCallbackDurationHistogram() const;
+  uint32_t getNumDroppedJobs() const { return m_numDropped; }
+
+private:
+  struct Job {
+    Reader *reader = nullptr;
+    uint32_t callbackIdentifier = 0;
+    SampleHandle sample;
+  };
+
+  struct Worker {
+    CallbackExecutor *executor = nullptr;
+    sys_sem_t signal{};
+    // One slot stays empty to tell a full ring from an empty one
+    std::array<Job, Config::CALLBACK_EXECUTOR_QUEUE_LENGTH + 1> jobs;
+    std::atomic<uint8_t> head{0};
+    std::atomic<uint8_t> tail{0};
+  };
+
+  static_assert(Config::CALLBACK_EXECUTOR_NUM_THREADS > 0,
+                "The executor needs at least one worker");
+  static_assert(Config::CALLBACK_EXECUTOR_QUEUE_LENGTH < 255,
+                "Ring indices are 8 bit");
+  static_assert(Config::CALLBACK_EXECUTOR_NUM_THREADS *
+                        Config::CALLBACK_EXECUTOR_QUEUE_LENGTH <
+                    Config::MAX_RETAINED_SAMPLES,
+                "Queued jobs must not use up all retained samples");
+
+  using AtomicHistogram =
+      std::array<std::atomic<uint32_t>,
+                 Config::CALLBACK_EXECUTOR_HISTOGRAM_BUCKETS>;
+
+  std::array<Worker, Config::CALLBACK_EXECUTOR_NUM_THREADS> m_workers;
+  // Serializes producers in case there are several receive threads
+  SemaphoreHandle_t m_producerMutex = nullptr;
+  std::atomic<bool> m_running{false};
+
+  AtomicHistogram m_queueDepth{};
+  AtomicHistogram m_callbackDuration{};
+  std::atomic<uint32_t> m_numDropped{0};
+
+  static void workerFunction(void *arg);
+  void run(Worker &worker);
+  static uint8_t getBucket(uint32_t value);
+  static Histogram toHistogram(const AtomicHistogram &histogram);
+};
+
+} // namespace rtps
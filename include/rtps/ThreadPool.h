@@ -25,8 +25,13 @@ class Writer;
 class ThreadPool {
 public:
   using receiveJumppad_fp = void (*)(void *callee, const PacketInfo &packet);
+  //! Runs deferred work on the reader thread. Returns the time in ms until
+  //! it needs to run again, 0 if nothing is pending.
+  using deferredWorkJumppad_fp = uint32_t (*)(void *callee);
 
-  ThreadPool(receiveJumppad_fp receiveCallback, void *callee);
+  ThreadPool(receiveJumppad_fp receiveCallback, void *callee,
+             deferredWorkJumppad_fp deferredWorkCallback = nullptr,
+             deferredWorkJumppad_fp deferredTransmitCallback = nullptr);
 
   ~ThreadPool();
 
@@ -37,6 +42,9 @@ public:
   bool addWorkload(Writer *workload);
   bool addNewPacket(PacketInfo &&packet);
 
+  //! Queues a received message, taking over p. Called by lwIP on the tcpip
+  //! thread and by UdpDriver on the sending thread for messages to this
+  //! node. Never blocks, the queues have their own mutex.
   static void readCallback(void *arg, udp_pcb *pcb, pbuf *p,
                            const ip_addr_t *addr, Ip4Port_t port);
 
@@ -44,6 +52,9 @@ public:
 
 private:
   receiveJumppad_fp m_receiveJumppad;
+  deferredWorkJumppad_fp m_deferredWorkJumppad;
+  //! Same as m_deferredWorkJumppad, but run by the writer threads
+  deferredWorkJumppad_fp m_deferredTransmitJumppad;
   void *m_callee;
   bool m_running = false;
   std::array<sys_thread_t, Config::THREAD_POOL_NUM_WRITERS> m_writers;
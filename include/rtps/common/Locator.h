@@ -143,6 +143,11 @@ struct LocatorIPv4 {
   inline bool isMulticastAddress() const {
     return UdpDriver::isMulticastAddress(getIp4Address());
   }
+
+  bool operator==(const LocatorIPv4 &other) const {
+    return kind == other.kind && address == other.address &&
+           port == other.port;
+  }
 };
 
 }
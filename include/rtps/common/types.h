@@ -175,6 +175,21 @@ struct SequenceNumber_t {
     ++*this;
     return tmp;
   }
+
+  uint64_t toUint64() const {
+    return (static_cast<uint64_t>(high) << 32) | low;
+  }
+
+  SequenceNumber_t operator+(uint32_t offset) const {
+    const uint64_t value = toUint64() + offset;
+    return SequenceNumber_t{static_cast<int32_t>(value >> 32),
+                            static_cast<uint32_t>(value)};
+  }
+
+  //! Distance to a smaller or equal sequence number
+  uint64_t operator-(const SequenceNumber_t &other) const {
+    return toUint64() - other.toUint64();
+  }
 };
 
 #define SNS_MAX_NUM_BITS 256
@@ -193,14 +208,47 @@ struct SequenceNumberSet {
   uint32_t numBits = 0;
   std::array<uint32_t, (SNS_MAX_NUM_BITS / 32)> bitMap{};
 
-  // We only need 1 byte because atm we don't store packets.
   bool isSet(uint32_t bit) const {
     if (bit >= SNS_MAX_NUM_BITS) {
       return true;
     }
     const auto bucket = static_cast<uint8_t>(bit / 32);
     const auto pos = static_cast<uint8_t>(bit % 32);
-    return (bitMap[bucket] & (1 << (31 - pos))) != 0;
+    return (bitMap[bucket] & (uint32_t{1} << (31 - pos))) != 0;
+  }
+
+  //! Sets the bit and extends numBits if required
+  void set(uint32_t bit) {
+    if (bit >= SNS_MAX_NUM_BITS) {
+      return;
+    }
+    bitMap[bit / 32] |= uint32_t{1} << (31 - (bit % 32));
+    if (numBits <= bit) {
+      numBits = bit + 1;
+    }
+  }
+
+  //! Number of 32 bit words required to represent numBits on the wire
+  uint32_t getNumWords() const { return (numBits + 31) / 32; }
+
+  /**
+   * Returns the first set bit that is not smaller than 'fromBit' or
+   * SNS_MAX_NUM_BITS if there is none. Walks whole words using count leading
+   * zeros instead of testing each bit.
+   */
+  uint32_t findNextSet(uint32_t fromBit) const {
+    const uint32_t end =
+        numBits < SNS_MAX_NUM_BITS ? numBits : SNS_MAX_NUM_BITS;
+    while (fromBit < end) {
+      const uint32_t pos = fromBit % 32;
+      const uint32_t word = bitMap[fromBit / 32] & (UINT32_MAX >> pos);
+      if (word != 0) {
+        const uint32_t bit = (fromBit - pos) + __builtin_clz(word);
+        return bit < end ? bit : SNS_MAX_NUM_BITS;
+      }
+      fromBit += 32 - pos;
+    }
+    return SNS_MAX_NUM_BITS;
   }
 };
 
@@ -208,6 +256,41 @@ struct FragmentNumber_t {
   uint32_t value;
 };
 
+#define FNS_MAX_NUM_BITS 256
+static_assert(!(FNS_MAX_NUM_BITS % 32) && FNS_MAX_NUM_BITS != 0,
+              "FNS_MAX_NUM_BITS must be multiple of 32");
+
+//! Fragment numbers start at 1, bit i refers to base + i
+struct FragmentNumberSet {
+  FragmentNumber_t base = {1};
+  uint32_t numBits = 0;
+  std::array<uint32_t, (FNS_MAX_NUM_BITS / 32)> bitMap{};
+
+  bool isSet(uint32_t bit) const {
+    if (bit >= numBits || bit >= FNS_MAX_NUM_BITS) {
+      return false;
+    }
+    return (bitMap[bit / 32] & (uint32_t{1} << (31 - (bit % 32)))) != 0;
+  }
+
+  //! Sets the bit and extends numBits if required
+  void set(uint32_t bit) {
+    if (bit >= FNS_MAX_NUM_BITS) {
+      return;
+    }
+    bitMap[bit / 32] |= uint32_t{1} << (31 - (bit % 32));
+    if (numBits <= bit) {
+      numBits = bit + 1;
+    }
+  }
+
+  bool contains(uint32_t fragmentNum) const {
+    return fragmentNum >= base.value && isSet(fragmentNum - base.value);
+  }
+
+  uint32_t getNumWords() const { return (numBits + 31) / 32; }
+};
+
 struct Count_t {
   int32_t value;
 };
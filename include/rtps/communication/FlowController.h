@@ -0,0 +1,62 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include <stdint.h>
+
+namespace rtps {
+
+//! Limits applied to a writer or a whole participant. Zero means unlimited.
+struct FlowControlSettings {
+  uint32_t bytesPerSecond = 0;
+  uint32_t packetsPerSecond = 0;
+};
+
+/**
+ * Token bucket that allows to run into debt. Instead of rejecting a
+ * transmission, the caller is told how long it has to wait until the bucket
+ * is balanced again. This way traffic is paced and not dropped.
+ */
+class TokenBucket {
+public:
+  void init(uint32_t ratePerSecond, uint32_t burst);
+  bool isUnlimited() const { return m_rate == 0; }
+
+  //! Takes the tokens and returns the time in ms until the debt is paid off
+  uint32_t consume(uint32_t amount, TickType_t now);
+
+private:
+  uint32_t m_rate = 0;
+  uint32_t m_burst = 0;
+  int64_t m_tokens = 0;
+  TickType_t m_lastRefill = 0;
+
+  void refill(TickType_t now);
+};
+
+class FlowController {
+public:
+  bool init(const FlowControlSettings &settings);
+  bool isUnlimited() const;
+
+  //! Thread-safe. Accounts a transmission and returns how many ms the sender
+  //! should wait before it goes on
+  uint32_t reserve(uint32_t bytes, uint32_t packets);
+
+private:
+  SemaphoreHandle_t m_mutex = nullptr;
+  TokenBucket m_bytes;
+  TokenBucket m_packets;
+};
+
+} // namespace rtps
@@ -0,0 +1,88 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/common/Locator.h"
+#include "rtps/common/types.h"
+#include "rtps/communication/PacketInfo.h"
+#include "rtps/config.h"
+#include "rtps/utils/Lock.h"
+
+#include <array>
+
+namespace rtps {
+
+/**
+ * Collects the submessages of all user writers of a participant and merges
+ * those to the same destination into a single RTPS message. A message is
+ * sent once it is older than the flush window or the next submessage would
+ * exceed Config::MAX_RTPS_MESSAGE_SIZE.
+ *
+ * Only user traffic goes through here. Metatraffic is sent directly by its
+ * writers so it is never held back and never mixed with user data.
+ */
+class TransmitAggregator {
+public:
+  using sendJumppad_fp = void (*)(void *callee, PacketInfo &packet);
+
+  bool init(const GuidPrefix_t &guidPrefix, uint16_t windowMs);
+  void setSender(sendJumppad_fp sendCallback, void *callee);
+  bool isEnabled() const;
+
+  /**
+   * Thread-safe. Calls append(PBufWrapper &) with a message to destination
+   * that has room for size more bytes. Returns false if the aggregator is
+   * disabled or no message could be allocated.
+   */
+  template <typename AppendSubmessage>
+  bool add(const LocatorIPv4 &destination, Ip4Port_t srcPort, DataSize_t size,
+           AppendSubmessage append) {
+    if (!isEnabled()) {
+      return false;
+    }
+    Lock lock{m_mutex};
+    PBufWrapper *buffer = prepare(destination, srcPort, size);
+    if (buffer == nullptr) {
+      return false;
+    }
+    append(*buffer);
+    return true;
+  }
+
+  //! Sends all messages older than the window. Returns the ticks until the
+  //! next one is due or 0 if nothing is pending.
+  TickType_t flushDue(TickType_t now);
+  void flushAll();
+  //! Thread-safe. Sends the pending message to destination right away, so
+  //! a submessage sent around the aggregator cannot overtake it.
+  void flush(const LocatorIPv4 &destination, Ip4Port_t srcPort);
+
+private:
+  struct PendingMessage {
+    bool inUse = false;
+    LocatorIPv4 destination;
+    TickType_t opened = 0;
+    PacketInfo info;
+  };
+
+  SemaphoreHandle_t m_mutex = nullptr;
+  GuidPrefix_t m_guidPrefix;
+  TickType_t m_window = 0;
+  sendJumppad_fp m_sendJumppad = nullptr;
+  void *m_callee = nullptr;
+  std::array<PendingMessage, Config::TRANSMIT_AGGREGATOR_MAX_DESTINATIONS>
+      m_messages;
+
+  PBufWrapper *prepare(const LocatorIPv4 &destination, Ip4Port_t srcPort,
+                       DataSize_t size);
+  void send(PendingMessage &message);
+};
+
+} // namespace rtps
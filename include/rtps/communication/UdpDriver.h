@@ -43,6 +43,9 @@ private:
 
   bool sendPacket(const UdpConnection &conn, const IPAddress &destAddr,
                   Ip4Port_t destPort, pbuf &buffer);
+  const UdpConnection *findConnection(Ip4Port_t port) const;
+  //! Returns false if the destination is not a port of this node
+  bool deliverLocally(PacketInfo &packet);
 };
 
 }
@@ -44,6 +44,10 @@ struct Config {
     static constexpr uint8_t NUM_WRITER_PROXIES_PER_READER = 1;
     static constexpr uint8_t NUM_READER_PROXIES_PER_WRITER = 1;
 
+    // Matched readers of other participants of the same Domain get samples
+    // passed directly instead of through UDP and the receive queue
+    static constexpr bool INTRA_PROCESS_DELIVERY = true;
+
     static constexpr uint8_t MAX_NUM_UNMATCHED_REMOTE_WRITERS = 15;
     static constexpr uint8_t MAX_NUM_UNMATCHED_REMOTE_READERS = 15;
         
@@ -51,6 +55,23 @@ struct Config {
 
     static constexpr uint8_t HISTORY_SIZE_STATELESS = 2;
     static constexpr uint8_t HISTORY_SIZE_STATEFUL = 10;
+    // Payloads up to this size are stored in the history slot itself instead
+    // of a pbuf. Costs this many bytes per history slot.
+    static constexpr uint8_t CACHE_CHANGE_INLINE_PAYLOAD_SIZE = 16;
+    // Out-of-order samples kept per writer proxy of a stateful reader. Each
+    // one holds a pbuf of the receive pool until the gap before it is filled.
+    static constexpr uint8_t SFR_REORDER_BUFFER_SIZE = 4;
+    // Receive pbufs the application may hold via SampleHandle at once
+    static constexpr uint16_t MAX_RETAINED_SAMPLES = 8;
+    // Upper bound for the optional per-reader delivery queue. Queued samples
+    // count against MAX_RETAINED_SAMPLES.
+    static constexpr uint8_t READER_SAMPLE_QUEUE_SIZE = 4;
+    // Readers a single WaitSet can block on
+    static constexpr uint8_t WAITSET_MAX_READERS = 4;
+    // ACKNACKs of stateful readers are delayed for this long. Requests to the
+    // same remote participant are sent in one message, repeated requests for
+    // the same writer are merged.
+    static constexpr uint16_t SFR_HEARTBEAT_RESPONSE_DELAY_MS = 10;
 
     static constexpr uint8_t MAX_TYPENAME_LENGTH = 32;
     static constexpr uint8_t MAX_TOPICNAME_LENGTH = 32;
@@ -61,6 +82,11 @@ struct Config {
     static constexpr uint16_t SPDP_WRITER_STACKSIZE = 4000;   // byte
 
     static constexpr uint16_t SF_WRITER_HB_PERIOD_MS = 4000;
+    // Repairs of stateful writers are delayed for this long to collect the
+    // requests of all readers. A sample is sent once to a multicast group if
+    // at least SFW_MULTICAST_REPAIR_MIN_READERS of its readers asked for it.
+    static constexpr uint16_t SFW_NACK_RESPONSE_DELAY_MS = 10;
+    static constexpr uint8_t SFW_MULTICAST_REPAIR_MIN_READERS = 2;
     static constexpr uint16_t SPDP_RESEND_PERIOD_MS = 1000;
     static constexpr uint8_t SPDP_CYCLECOUNT_HEARTBEAT = 2; // skip x SPDP rounds before checking liveliness
     static constexpr uint8_t SPDP_WRITER_PRIO = 24;
@@ -72,6 +98,48 @@ struct Config {
     static constexpr Duration_t SPDP_LEASE_DURATION = {5, 0};
 
     static constexpr int MAX_NUM_UDP_CONNECTIONS = 10;
+    // Unicast messages to a port of this node are passed to the receive
+    // callback directly instead of through the lwIP stack
+    static constexpr bool UDP_LOCAL_BYPASS = true;
+    // Readers that need to share a multicast locator before a writer sends to
+    // the group instead of each reader. 0 disables multicast.
+    static constexpr uint8_t WRITER_MULTICAST_MIN_READERS = 2;
+    // Largest RTPS message built when coalescing submessages. Matches the UDP
+    // payload of an unfragmented IPv4 packet on a 1500 byte MTU.
+    static constexpr uint16_t MAX_RTPS_MESSAGE_SIZE = 1472;
+    // Larger payloads are sent as DATA_FRAG of this size each. Has to fit
+    // into MAX_RTPS_MESSAGE_SIZE together with the message headers.
+    static constexpr uint16_t DATA_FRAG_SIZE = 1024;
+    // Samples a reader reassembles at once and their maximum size
+    static constexpr uint8_t MAX_NUM_FRAGMENTED_SAMPLES = 2;
+    static constexpr uint16_t MAX_FRAGMENTED_SAMPLE_SIZE = 32768;
+    // The payload compressor keeps 2^bits 16 bit entries on the stack of the
+    // thread writing the sample
+    static constexpr uint8_t COMPRESSION_HASH_BITS = 9;
+
+    // Dedicated pbuf slabs per traffic class, see PBufAllocator.h. Every
+    // element additionally holds the lwIP header room. The defaults take
+    // roughly 20 KiB.
+    static constexpr uint16_t PBUF_SLAB_SMALL_ELEMENT_SIZE = 256;
+    static constexpr uint16_t PBUF_SLAB_LARGE_ELEMENT_SIZE =
+        MAX_RTPS_MESSAGE_SIZE;
+    static constexpr uint8_t PBUF_SLAB_USER_TX_SMALL = 6;
+    static constexpr uint8_t PBUF_SLAB_USER_TX_LARGE = 2;
+    static constexpr uint8_t PBUF_SLAB_META_TX_SMALL = 4;
+    static constexpr uint8_t PBUF_SLAB_META_TX_LARGE = 2;
+    static constexpr uint8_t PBUF_SLAB_HISTORY_SMALL = 12;
+    static constexpr uint8_t PBUF_SLAB_HISTORY_LARGE = 4;
+
+    // Pacing of user traffic, 0 means unlimited. Metatraffic is never paced.
+    static constexpr uint32_t FLOW_CONTROL_PARTICIPANT_BYTES_PER_SEC = 0;
+    static constexpr uint32_t FLOW_CONTROL_PARTICIPANT_PACKETS_PER_SEC = 0;
+    static constexpr uint16_t FLOW_CONTROL_MAX_BURST_MS = 20;
+    static constexpr uint16_t FLOW_CONTROL_MIN_BURST_BYTES = 1500;
+
+    // User DATA of all writers of a participant to the same locator is merged
+    // for up to this long. 0 sends every submessage on its own.
+    static constexpr uint16_t TRANSMIT_AGGREGATION_WINDOW_MS = 2;
+    static constexpr uint8_t TRANSMIT_AGGREGATOR_MAX_DESTINATIONS = 4;
 
     static constexpr int THREAD_POOL_NUM_WRITERS = 1;
     static constexpr int THREAD_POOL_NUM_READERS = 1;
@@ -79,11 +147,22 @@ struct Config {
     static constexpr int THREAD_POOL_READER_PRIO = 24;
     static constexpr int THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC = 60;
     static constexpr int THREAD_POOL_WORKLOAD_QUEUE_LENGTH_METATRAFFIC = 60;
+
+    // Worker threads running deferred reader callbacks. Callbacks of one
+    // reader always run on the same worker.
+    static constexpr int CALLBACK_EXECUTOR_NUM_THREADS = 1;
+    static constexpr int CALLBACK_EXECUTOR_STACKSIZE = 4000; // byte
+    static constexpr int CALLBACK_EXECUTOR_PRIO = 20;
+    // Each queued job retains its sample. All queues together stay below
+    // MAX_RETAINED_SAMPLES, so slow callbacks leave some to sample queues.
+    static constexpr uint8_t CALLBACK_EXECUTOR_QUEUE_LENGTH = 4;
+    static constexpr uint8_t CALLBACK_EXECUTOR_HISTOGRAM_BUCKETS = 8;
     static constexpr int OVERALL_HEAP_SIZE =
         THREAD_POOL_NUM_WRITERS * THREAD_POOL_WRITER_STACKSIZE +
         THREAD_POOL_NUM_READERS * THREAD_POOL_READER_STACKSIZE +
         MAX_NUM_PARTICIPANTS * SPDP_WRITER_STACKSIZE +
-        NUM_STATEFUL_WRITERS * HEARTBEAT_STACKSIZE;
+        NUM_STATEFUL_WRITERS * HEARTBEAT_STACKSIZE +
+        CALLBACK_EXECUTOR_NUM_THREADS * CALLBACK_EXECUTOR_STACKSIZE;
 };
 
 };
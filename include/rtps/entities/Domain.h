@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "rtps/CallbackExecutor.h"
 #include "rtps/ThreadPool.h"
 #include "rtps/config.h"
 #include "rtps/entities/Participant.h"
@@ -31,10 +32,12 @@ public:
   Participant *createParticipant();
   Writer *createWriter(Participant &part, const char *topicName,
                        const char *typeName, bool reliable,
-                       bool enforceUnicast = false);
+                       bool enforceUnicast = false,
+                       const WriterOptions &options = WriterOptions{});
   Reader *createReader(Participant &part, const char *topicName,
                        const char *typeName, bool reliable,
-                       ip4_addr_t mcastaddress = {0});
+                       ip4_addr_t mcastaddress = {0},
+                       const ReaderOptions &options = ReaderOptions{});
 
   Writer *writerExists(Participant &part, const char *topicName,
                        const char *typeName, bool reliable);
@@ -49,6 +52,7 @@ public:
 private:
   friend class SizeInspector;
   ThreadPool m_threadPool;
+  CallbackExecutor m_callbackExecutor;
   UdpDriver m_transport;
   std::array<Participant, Config::MAX_NUM_PARTICIPANTS> m_participants;
   const uint8_t PARTICIPANT_START_ID = 0;
@@ -76,6 +80,16 @@ private:
   void registerPort(const Participant &part);
   void registerMulticastPort(FullLengthLocator mcastLocator);
   static void receiveJumppad(void *callee, const PacketInfo &packet);
+  static uint32_t deferredWorkJumppad(void *callee);
+  //! Sends due ACKNACKs and repairs, returns the ms until the next is due
+  uint32_t runDeferredWork();
+  static uint32_t deferredTransmitJumppad(void *callee);
+  static void aggregatorSendJumppad(void *callee, PacketInfo &packet);
+  static Reader *localReaderJumppad(void *callee, const Guid_t &guid);
+  Reader *findLocalReader(const Guid_t &guid);
+  //! Sends due aggregated messages and resumes paced writers, returns the
+  //! ms until the next is due
+  uint32_t flushTransmitAggregators();
 };
 
 }
@@ -0,0 +1,135 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/common/Locator.h"
+#include "rtps/config.h"
+#include "rtps/entities/ReaderProxy.h"
+
+#include <array>
+
+namespace rtps {
+
+/**
+ * Groups the reader proxies of a writer by their multicast locator. Once a
+ * group reaches the configured number of readers, its first member sends for
+ * all of them via multicast and the others suppress unicast. Below the
+ * threshold every member is served by unicast again.
+ *
+ * The index is updated on each match and unmatch and only touches the
+ * affected group. Proxies must not move in memory while they are indexed.
+ * Not thread-safe, has to be guarded by the writer.
+ */
+template <uint8_t MAX_PROXIES> class MulticastGroupIndex {
+public:
+  //! 0 disables multicast entirely
+  void setMinReaders(uint8_t minReaders) {
+    m_minReaders = minReaders;
+    for (auto &group : m_groups) {
+      if (group.numMembers != 0) {
+        update(group);
+      }
+    }
+  }
+
+  void clear() {
+    for (auto &group : m_groups) {
+      group.locator = LocatorIPv4{};
+      group.numMembers = 0;
+    }
+  }
+
+  bool add(ReaderProxy &proxy) {
+    proxy.useMulticast = false;
+    proxy.suppressUnicast = false;
+    proxy.unknown_eid = false;
+    if (proxy.remoteMulticastLocator.kind !=
+        LocatorKind_t::LOCATOR_KIND_UDPv4) {
+      return true;
+    }
+
+    Group *group = findGroup(proxy.remoteMulticastLocator);
+    if (group == nullptr) {
+      group = findGroup(LocatorIPv4{});
+      if (group == nullptr) {
+        return false;
+      }
+      group->locator = proxy.remoteMulticastLocator;
+    }
+    if (group->numMembers == MAX_PROXIES) {
+      return false;
+    }
+    group->members[group->numMembers++] = &proxy;
+    update(*group);
+    return true;
+  }
+
+  void remove(const ReaderProxy &proxy) {
+    for (auto &group : m_groups) {
+      for (uint8_t i = 0; i < group.numMembers; ++i) {
+        if (group.members[i] != &proxy) {
+          continue;
+        }
+        // Keep the order, the first member is the one sending
+        for (uint8_t j = i + 1; j < group.numMembers; ++j) {
+          group.members[j - 1] = group.members[j];
+        }
+        --group.numMembers;
+        if (group.numMembers == 0) {
+          group.locator = LocatorIPv4{};
+        } else {
+          update(group);
+        }
+        return;
+      }
+    }
+  }
+
+private:
+  struct Group {
+    LocatorIPv4 locator;
+    std::array<ReaderProxy *, MAX_PROXIES> members{};
+    uint8_t numMembers = 0;
+  };
+
+  std::array<Group, MAX_PROXIES> m_groups{};
+  uint8_t m_minReaders = Config::WRITER_MULTICAST_MIN_READERS;
+
+  Group *findGroup(const LocatorIPv4 &locator) {
+    for (auto &group : m_groups) {
+      if (group.locator == locator) {
+        return &group;
+      }
+    }
+    return nullptr;
+  }
+
+  void update(Group &group) {
+    const bool promote =
+        m_minReaders != 0 && group.numMembers >= m_minReaders;
+    bool differentIds = false;
+    for (uint8_t i = 1; i < group.numMembers; ++i) {
+      if (group.members[i]->remoteReaderGuid.entityId !=
+          group.members[0]->remoteReaderGuid.entityId) {
+        differentIds = true;
+        break;
+      }
+    }
+
+    for (uint8_t i = 0; i < group.numMembers; ++i) {
+      ReaderProxy &member = *group.members[i];
+      member.useMulticast = promote && i == 0;
+      member.suppressUnicast = promote;
+      member.unknown_eid = promote && i == 0 && differentIds;
+    }
+  }
+};
+
+} // namespace rtps
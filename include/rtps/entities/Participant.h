@@ -10,6 +10,9 @@
 #pragma once
 
 #include "rtps/common/types.h"
+#include "rtps/communication/FlowController.h"
+#include "rtps/communication/PacketInfo.h"
+#include "rtps/communication/TransmitAggregator.h"
 #include "rtps/config.h"
 #include "rtps/discovery/SEDPAgent.h"
 #include "rtps/discovery/SPDPAgent.h"
@@ -22,6 +25,8 @@ class Reader;
 
 class Participant {
 public:
+  using localReaderLookup_fp = Reader *(*)(void *callee, const Guid_t &guid);
+
   GuidPrefix_t m_guidPrefix;
   ParticipantId_t m_participantId;
 
@@ -76,6 +81,10 @@ public:
   void removeProxyFromAllEndpoints(const Guid_t &guid);
 
   const ParticipantProxyData *findRemoteParticipant(const GuidPrefix_t &prefix);
+  //! Resolves readers of participants living in the same Domain
+  void setLocalReaderLookup(localReaderLookup_fp lookup, void *callee);
+  //! Returns a nullptr if the reader is not part of the same Domain
+  Reader *findLocalReader(const Guid_t &guid);
   void refreshRemoteParticipantLiveliness(const GuidPrefix_t &prefix);
   uint32_t getRemoteParticipantCount();
   MessageReceiver *getMessageReceiver();
@@ -83,12 +92,30 @@ public:
 
   bool hasReaderWithMulticastLocator(const IPAddress& address);
 
+  /**
+   * Builds one message with all due ACKNACKs of the readers that go to the
+   * same destination. Returns false if nothing is due, waitTicks then holds
+   * the time until the next ACKNACK is due or 0 if there is none.
+   */
+  bool collectDueAckNacks(TickType_t now, PacketInfo &info,
+                          TickType_t &waitTicks);
+  //! Lets all writers answer requests whose NACK response delay passed
+  void sendDueRepairs(TickType_t now, TickType_t &waitTicks);
+  //! Schedules the writers whose flow control budget allows sending again
+  void resumePacedWriters(TickType_t now, TickType_t &waitTicks);
+
   void addBuiltInEndpoints(BuiltInEndpoints &endpoints);
-  void newMessage(const uint8_t *data, DataSize_t size);
+  void newMessage(const uint8_t *data, DataSize_t size,
+                  pbuf *buffer = nullptr);
 
   SPDPAgent &getSPDPAgent();
   void printInfo();
 
+  //! Limits the combined user traffic of all writers of this participant
+  bool setUserTrafficLimits(const FlowControlSettings &settings);
+  FlowController &getUserTrafficFlowController();
+  TransmitAggregator &getTransmitAggregator();
+
 private:
   friend class SizeInspector;
   MessageReceiver m_receiver;
@@ -100,6 +127,10 @@ private:
       nullptr};
 
   SemaphoreHandle_t m_mutex;
+  localReaderLookup_fp m_localReaderLookup = nullptr;
+  void *m_localReaderLookupCallee = nullptr;
+  FlowController m_userTrafficFlowController;
+  TransmitAggregator m_transmitAggregator;
   MemoryPool<ParticipantProxyData, Config::SPDP_MAX_NUMBER_FOUND_PARTICIPANTS>
       m_remoteParticipants;
 
@@ -0,0 +1,105 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/config.h"
+#include "rtps/messages/Encapsulation.h"
+#include "rtps/utils/ArrayKernels.h"
+#include "rtps/utils/Diagnostics.h"
+#include "ucdr/microcdr.h"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace rtps {
+
+/**
+ * Serialization for fixed-layout types whose wire format equals their memory
+ * layout, i.e. without padding between fields. Use with TypedWriter and
+ * TypedReader by deriving and adding the names:
+ *
+ *   struct ImuTopic : PlainTraits<Imu, float> {
+ *     static constexpr const char *TOPIC_NAME = "imu";
+ *     static constexpr const char *TYPE_NAME = "Imu";
+ *   };
+ *
+ * Word is the size of every field of T. It is only needed to swap the byte
+ * order if sender and receiver differ in endianness.
+ */
+template <typename T, typename Word = T> struct PlainTraits {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Plain topics need trivially copyable types");
+  static_assert(sizeof(T) % sizeof(Word) == 0,
+                "T has to consist of Word sized fields");
+  static_assert(sizeof(Word) == 1 || sizeof(Word) == 2 || sizeof(Word) == 4 ||
+                    sizeof(Word) == 8,
+                "Unsupported word size");
+
+  using Type = T;
+  static constexpr DataSize_t MAX_SERIALIZED_SIZE = sizeof(T);
+
+  //! A single copy in the native byte order
+  static bool serialize(ucdrBuffer &buffer, const T &sample) {
+    return ucdr_serialize_array_uint8_t(
+        &buffer, reinterpret_cast<const uint8_t *>(&sample), sizeof(T));
+  }
+
+  static bool deserialize(ucdrBuffer &buffer, T &sample) {
+    auto *bytes = reinterpret_cast<uint8_t *>(&sample);
+    if (!ucdr_deserialize_array_uint8_t(&buffer, bytes, sizeof(T))) {
+      return false;
+    }
+    if (buffer.endianness != ArrayKernels::getNativeEndianness()) {
+      swapWords(bytes);
+    }
+    return true;
+  }
+
+  /**
+   * Returns the sample in the received payload without copying it if it is
+   * aligned and in the native byte order. Otherwise, it is copied into
+   * fallback and a pointer to that is returned. The pointer is always
+   * suitably aligned. nullptr if the payload is invalid.
+   */
+  static const T *access(const uint8_t *data, DataSize_t size, T &fallback) {
+    ucdrEndianness endianness;
+    if (!Encapsulation::readHeader(data, size, endianness) ||
+        size < Encapsulation::HEADER_SIZE + sizeof(T)) {
+      return nullptr;
+    }
+
+    const uint8_t *payload = data + Encapsulation::HEADER_SIZE;
+    const bool aligned =
+        reinterpret_cast<uintptr_t>(payload) % alignof(T) == 0;
+    if (aligned && endianness == ArrayKernels::getNativeEndianness()) {
+      return reinterpret_cast<const T *>(payload);
+    }
+
+    if (!aligned) {
+      // Depends on where lwIP places the payload, see ETH_PAD_SIZE
+      Diagnostics::Network::unaligned_plain_samples++;
+    }
+    auto *bytes = reinterpret_cast<uint8_t *>(&fallback);
+    memcpy(bytes, payload, sizeof(T));
+    if (endianness != ArrayKernels::getNativeEndianness()) {
+      swapWords(bytes);
+    }
+    return &fallback;
+  }
+
+private:
+  static void swapWords(uint8_t *bytes) {
+    ArrayKernels::copySwapped(bytes, bytes, sizeof(T) / sizeof(Word),
+                              sizeof(Word));
+  }
+};
+
+} // namespace rtps
@@ -11,12 +11,16 @@
 
 #include <cstring>
 
+#include "FreeRTOS.h"
 #include "rtps/common/types.h"
 #include "rtps/config.h"
 #include "rtps/discovery/TopicData.h"
 #include "rtps/entities/WriterProxy.h"
+#include "rtps/storages/FragmentAssembler.h"
 #include "rtps/storages/MemoryPool.h"
 #include "rtps/storages/PBufWrapper.h"
+#include "rtps/storages/SampleHandle.h"
+#include "rtps/storages/SampleQueue.h"
 #include "semphr.h"
 
 
@@ -24,10 +28,14 @@ namespace rtps {
 
 struct SubmessageHeartbeat;
 struct SubmessageGap;
+struct SubmessageDataFrag;
+struct SubmessageHeartbeatFrag;
+class CallbackExecutor;
 
 class ReaderCacheChange {
 private:
   const uint8_t *data;
+  pbuf *buffer;
 
 public:
   const ChangeKind_t kind;
@@ -35,9 +43,11 @@ public:
   const Guid_t writerGuid;
   const SequenceNumber_t sn;
 
-  ReaderCacheChange(ChangeKind_t kind, Guid_t &writerGuid, SequenceNumber_t sn,
-                    const uint8_t *data, DataSize_t size)
-      : data(data), kind(kind), size(size), writerGuid(writerGuid), sn(sn){};
+  ReaderCacheChange(ChangeKind_t kind, const Guid_t &writerGuid,
+                    SequenceNumber_t sn, const uint8_t *data, DataSize_t size,
+                    pbuf *buffer = nullptr)
+      : data(data), buffer(buffer), kind(kind), size(size),
+        writerGuid(writerGuid), sn(sn){};
 
   ~ReaderCacheChange() =
       default; // No need to free data. It's not owned by this object
@@ -59,9 +69,36 @@ public:
 
   const uint8_t *getData() const { return data; }
 
+  //! The received pbuf data points into. Might be a nullptr.
+  pbuf *getPbuf() const { return buffer; }
+
+  //! Keeps the sample beyond the callback without copying. The handle is
+  //! invalid if there is no pbuf or too many samples are retained already.
+  SampleHandle retain() const {
+    return SampleHandle{kind, writerGuid, sn, buffer, data, size};
+  }
+
   const DataSize_t getDataSize() const { return size; }
 };
 
+//! Optional per-reader settings passed to Domain::createReader
+struct ReaderOptions {
+  //! Samples are queued for Reader::takeSample instead of being passed to
+  //! the callbacks on the receive thread if not 0. At most
+  //! Config::READER_SAMPLE_QUEUE_SIZE.
+  uint8_t sampleQueueDepth = 0;
+  //! Keeps only the newest queued sample of each writer
+  bool conflatePerWriter = false;
+};
+
+//! Where a reader callback is executed
+enum class CallbackMode : uint8_t {
+  //! On the receive thread, for cheap callbacks only
+  INLINE,
+  //! On a worker of the CallbackExecutor of the domain
+  DEFERRED
+};
+
 typedef void (*ddsReaderCallback_fp)(void *callee,
                                      const ReaderCacheChange &cacheChange);
 
@@ -72,16 +109,43 @@ public:
 
   TopicData m_attributes;
   virtual void newChange(const ReaderCacheChange &cacheChange) = 0;
-  virtual callbackIdentifier_t registerCallback(callbackFunction_t cb,
-                                                void *arg);
+  virtual callbackIdentifier_t
+  registerCallback(callbackFunction_t cb, void *arg,
+                   CallbackMode mode = CallbackMode::INLINE);
   virtual bool removeCallback(callbackIdentifier_t identifier);
   uint8_t getNumCallbacks();
+  //! Deferred callbacks run inline as long as there is no running executor
+  void setCallbackExecutor(CallbackExecutor *executor);
+
+  //! Decouples the application from the receive thread, see ReaderOptions.
+  //! depth 0 switches back to callbacks.
+  bool setSampleQueue(uint8_t depth, bool conflatePerWriter);
+  //! Takes the oldest queued sample, waiting up to timeoutMs for one
+  bool takeSample(SampleHandle &sample, uint32_t timeoutMs = 0);
+  //! Takes up to maxSamples queued samples, waiting up to timeoutMs for the
+  //! first one. Returns the number of samples taken.
+  uint8_t take(SampleHandle *samples, uint8_t maxSamples,
+               uint32_t timeoutMs = 0);
+  //! Same as take but leaves the samples in the queue
+  uint8_t read(SampleHandle *samples, uint8_t maxSamples);
+  bool hasSamples();
+  const SampleQueue<Config::READER_SAMPLE_QUEUE_SIZE> &getSampleQueue() const {
+    return m_sampleQueue;
+  }
 
   virtual bool onNewHeartbeat(const SubmessageHeartbeat &msg,
                               const GuidPrefix_t &remotePrefix) = 0;
   virtual bool onNewGapMessage(const SubmessageGap &msg,
                                const GuidPrefix_t &remotePrefix) = 0;
   virtual bool addNewMatchedWriter(const WriterProxy &newProxy) = 0;
+
+  //! Reassembles DATA_FRAG, complete samples are passed to newChange
+  void newFragments(const SubmessageDataFrag &msg,
+                    const GuidPrefix_t &remotePrefix, const uint8_t *data,
+                    DataSize_t size);
+  //! Requests missing fragments, only reliable readers do
+  virtual bool onNewHeartbeatFrag(const SubmessageHeartbeatFrag &msg,
+                                  const GuidPrefix_t &remotePrefix);
   virtual bool removeProxy(const Guid_t &guid);
   virtual void removeAllProxiesOfParticipant(const GuidPrefix_t &guidPrefix);
   bool isInitialized() { return m_is_initialized_; }
@@ -100,9 +164,36 @@ public:
 
   virtual bool sendPreemptiveAckNack(const WriterProxy &writer);
 
+  /**
+   * Deferred ACKNACKs. Returns true and the destination if at least one of
+   * them is due. Otherwise, waitTicks is set to the time until the next one
+   * is due or 0 if there is none.
+   */
+  virtual bool getDueAckNackDestination(TickType_t now,
+                                        LocatorIPv4 &destination,
+                                        TickType_t &waitTicks);
+  //! Appends all due ACKNACKs for destination as long as the message has room
+  virtual void appendDueAckNacks(TickType_t now,
+                                 const LocatorIPv4 &destination,
+                                 PBufWrapper &buffer);
+
 protected:
-  void executeCallbacks(const ReaderCacheChange &cacheChange);
+  friend class WaitSet;
+  friend class CallbackExecutor;
+
+  //! Decompresses and decodes the payload first if the writer compressed
+  //! or delta encoded it. Deltas need the proxy of the writer.
+  void executeCallbacks(const ReaderCacheChange &cacheChange,
+                        WriterProxy *proxy = nullptr);
+  //! Runs the callback unless it was removed in the meantime
+  void executeDeferredCallback(callbackIdentifier_t identifier,
+                               const ReaderCacheChange &cacheChange);
   bool initMutex();
+  //! Drops all proxies including the samples they still hold
+  void clearProxies();
+  //! Fragments of samples that are not needed anymore are dropped early
+  virtual bool isFragmentRelevant(const Guid_t &writerGuid,
+                                  const SequenceNumber_t &sn);
 
   SequenceNumber_t m_sedp_sequence_number;
 
@@ -110,6 +201,8 @@ protected:
   Reader();
   virtual ~Reader() = default;
   MemoryPool<WriterProxy, Config::NUM_WRITER_PROXIES_PER_READER> m_proxies;
+  //! Samples in reassembly, guarded by m_proxies_mutex
+  FragmentAssembler<Config::MAX_NUM_FRAGMENTED_SAMPLES> m_fragments;
 
   callbackIdentifier_t m_callback_identifier = 1;
 
@@ -118,15 +211,23 @@ protected:
     callbackFunction_t function;
     void *arg;
     callbackIdentifier_t identifier;
+    CallbackMode mode;
   };
 
   std::array<callbackElement_t, Config::MAX_NUM_READER_CALLBACKS> m_callbacks;
 
+  SampleQueue<Config::READER_SAMPLE_QUEUE_SIZE> m_sampleQueue;
+  CallbackExecutor *mp_callbackExecutor = nullptr;
+
   // Guards manipulation of the proxies array
   SemaphoreHandle_t m_proxies_mutex = nullptr;
 
   // Guards manipulation of callback array
   SemaphoreHandle_t m_callback_mutex = nullptr;
+
+private:
+  //! Hands a plain sample to the queue or the callbacks
+  void dispatchSample(const ReaderCacheChange &cacheChange);
 };
 
 }
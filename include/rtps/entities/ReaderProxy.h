@@ -9,13 +9,17 @@
 
 #pragma once
 
+#include "FreeRTOS.h"
 #include "rtps/common/types.h"
 #include "rtps/discovery/ParticipantProxyData.h"
 
 namespace rtps {
+class Reader;
+
 struct ReaderProxy {
   Guid_t remoteReaderGuid;
   Count_t ackNackCount = {0};
+  Count_t nackFragCount = {0};
   LocatorIPv4 remoteLocator;
   bool is_reliable = false;
   LocatorIPv4 remoteMulticastLocator;
@@ -25,6 +29,18 @@ struct ReaderProxy {
   bool finalFlag = false;
   SequenceNumber_t lastAckNackSequenceNumber = {0, 1};
 
+  //! Latest request of the reader, answered after the NACK response delay
+  SequenceNumberSet requestedRepairs;
+  bool repairPending = false;
+  TickType_t repairScheduled = 0;
+  //! Delta encoded samples before this one refer to bases the reader never
+  //! got, they are skipped with a GAP
+  SequenceNumber_t firstDecodableSN = {0, 0};
+
+  //! Set if the reader belongs to another participant of the same Domain.
+  //! DATA is then handed over directly, everything else uses the network.
+  Reader *localReader = nullptr;
+
   ReaderProxy()
       : remoteReaderGuid({GUIDPREFIX_UNKNOWN, ENTITYID_UNKNOWN}),
         ackNackCount{0}, remoteLocator(LocatorIPv4()), finalFlag(false){};
@@ -0,0 +1,64 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/common/types.h"
+#include "rtps/utils/ArrayKernels.h"
+#include "ucdr/microcdr.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace rtps {
+
+//! Bounded sequence of numbers as in IDL sequence<T, MAX_LENGTH>
+template <typename T, uint32_t MAX_LENGTH> struct NumericSequence {
+  uint32_t length = 0;
+  std::array<T, MAX_LENGTH> values;
+};
+
+/**
+ * Serialization for topics made of a single numeric sequence, e.g. scan
+ * ranges or occupancy grids. Use with TypedWriter and TypedReader by
+ * deriving and adding the names:
+ *
+ *   struct RangesTopic : SequenceTraits<float, 360> {
+ *     static constexpr const char *TOPIC_NAME = "ranges";
+ *     static constexpr const char *TYPE_NAME = "Ranges";
+ *   };
+ *
+ * The elements are copied at once and only byte swapped if sender and
+ * receiver differ in endianness.
+ */
+template <typename T, uint32_t MAX_LENGTH> struct SequenceTraits {
+  using Type = NumericSequence<T, MAX_LENGTH>;
+  // Length, padding up to the alignment of T and the elements
+  static constexpr uint32_t SERIALIZED_SIZE =
+      4 + (sizeof(T) > 4 ? sizeof(T) - 4 : 0) + MAX_LENGTH * sizeof(T);
+  static_assert(SERIALIZED_SIZE <= std::numeric_limits<DataSize_t>::max(),
+                "Sequence does not fit into a sample");
+  static constexpr DataSize_t MAX_SERIALIZED_SIZE = SERIALIZED_SIZE;
+
+  static bool serialize(ucdrBuffer &buffer, const Type &sample) {
+    if (sample.length > MAX_LENGTH) {
+      return false;
+    }
+    return ArrayKernels::serializeSequence(buffer, sample.values.data(),
+                                           sample.length);
+  }
+
+  static bool deserialize(ucdrBuffer &buffer, Type &sample) {
+    return ArrayKernels::deserializeSequence(buffer, sample.values.data(),
+                                             MAX_LENGTH, sample.length);
+  }
+};
+
+} // namespace rtps
@@ -29,12 +29,32 @@ public:
                       const GuidPrefix_t &remotePrefix) override;
   bool onNewGapMessage(const SubmessageGap &msg,
                        const GuidPrefix_t &remotePrefix) override;
+  bool onNewHeartbeatFrag(const SubmessageHeartbeatFrag &msg,
+                          const GuidPrefix_t &remotePrefix) override;
 
   bool sendPreemptiveAckNack(const WriterProxy &writer) override;
 
+  bool getDueAckNackDestination(TickType_t now, LocatorIPv4 &destination,
+                                TickType_t &waitTicks) override;
+  void appendDueAckNacks(TickType_t now, const LocatorIPv4 &destination,
+                         PBufWrapper &buffer) override;
+
+protected:
+  bool isFragmentRelevant(const Guid_t &writerGuid,
+                          const SequenceNumber_t &sn) override;
+
 private:
   Ip4Port_t m_srcPort; // TODO intended for reuse but buffer not used as such
   NetworkDriver *m_transport;
+
+  //! Hands out buffered samples as long as they continue expectedSN
+  void deliverBufferedSamples(WriterProxy &proxy);
+  //! Moves expectedSN to sn, delivering buffered samples on the way
+  void skipTo(WriterProxy &proxy, const SequenceNumber_t &sn);
+  //! Marks the sequence numbers declared irrelevant by a GAP as received
+  void markIrrelevant(WriterProxy &proxy, const SubmessageGap &msg);
+  //! Requests everything missing up to lastSN once the response delay passed
+  void scheduleAckNack(WriterProxy &proxy, const SequenceNumber_t &lastSN);
 };
 
 using StatefulReader = StatefulReaderT<UdpDriver>;
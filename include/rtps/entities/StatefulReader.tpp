@@ -41,7 +41,7 @@ bool StatefulReaderT<NetworkDriver>::init(const TopicData &attributes,
     return false;
   }
 
-  m_proxies.clear();
+  clearProxies();
   m_attributes = attributes;
   m_transport = &driver;
   m_srcPort = attributes.unicastLocator.port;
@@ -52,7 +52,9 @@ bool StatefulReaderT<NetworkDriver>::init(const TopicData &attributes,
 template <class NetworkDriver>
 void StatefulReaderT<NetworkDriver>::newChange(
     const ReaderCacheChange &cacheChange) {
-  if (m_callback_count == 0 || !m_is_initialized_) {
+  // Readers consuming through take() or a WaitSet have no callbacks
+  if ((m_callback_count == 0 && !m_sampleQueue.isEnabled()) ||
+      !m_is_initialized_) {
     return;
   }
   Lock lock{m_proxies_mutex};
@@ -65,24 +67,85 @@ void StatefulReaderT<NetworkDriver>::newChange(
                 cacheChange.writerGuid.prefix.id[1],
                 cacheChange.writerGuid.prefix.id[2],
                 cacheChange.writerGuid.prefix.id[3]);
-        executeCallbacks(cacheChange);
-        ++proxy.expectedSN;
+        executeCallbacks(cacheChange, &proxy);
+        proxy.advanceExpectedSN(cacheChange.sn + 1);
+        deliverBufferedSamples(proxy);
         SFR_LOG("Done processing SN %u.%u\r\n", (int)cacheChange.sn.high,
                (int)cacheChange.sn.low);
         return;
-      } else {
-        Diagnostics::StatefulReader::sfr_unexpected_sn++;
-        SFR_LOG(
-            "Unexpected SN %u.%u != %u.%u, dropping! GUID %u %u %u %u | \r\n",
-            (int)proxy.expectedSN.high, (int)proxy.expectedSN.low,
-            (int)cacheChange.sn.high, (int)cacheChange.sn.low,
-            cacheChange.writerGuid.prefix.id[0],
-            cacheChange.writerGuid.prefix.id[1],
-            cacheChange.writerGuid.prefix.id[2],
-            cacheChange.writerGuid.prefix.id[3]);
       }
+
+      // Keep early samples until the gap before them is filled
+      if (proxy.expectedSN < cacheChange.sn &&
+          !proxy.isReceived(cacheChange.sn) &&
+          proxy.reorderBuffer.insert(cacheChange.sn, cacheChange.kind,
+                                     cacheChange.getPbuf(),
+                                     cacheChange.getData(),
+                                     cacheChange.getDataSize())) {
+        if (proxy.markReceived(cacheChange.sn)) {
+          Diagnostics::StatefulReader::sfr_buffered_out_of_order++;
+          SFR_LOG("Buffering SN %u.%u, expecting %u.%u\r\n",
+                  (int)cacheChange.sn.high, (int)cacheChange.sn.low,
+                  (int)proxy.expectedSN.high, (int)proxy.expectedSN.low);
+          return;
+        }
+        // Beyond the tracked window, it would never be delivered
+        BufferedSample *sample = proxy.reorderBuffer.find(cacheChange.sn);
+        proxy.reorderBuffer.release(*sample);
+      } else if (proxy.expectedSN < cacheChange.sn &&
+                 proxy.reorderBuffer.isFull()) {
+        Diagnostics::StatefulReader::sfr_reorder_buffer_overflows++;
+      }
+
+      Diagnostics::StatefulReader::sfr_unexpected_sn++;
+      SFR_LOG(
+          "Unexpected SN %u.%u != %u.%u, dropping! GUID %u %u %u %u | \r\n",
+          (int)proxy.expectedSN.high, (int)proxy.expectedSN.low,
+          (int)cacheChange.sn.high, (int)cacheChange.sn.low,
+          cacheChange.writerGuid.prefix.id[0],
+          cacheChange.writerGuid.prefix.id[1],
+          cacheChange.writerGuid.prefix.id[2],
+          cacheChange.writerGuid.prefix.id[3]);
+      return;
+    }
+  }
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::deliverBufferedSamples(
+    WriterProxy &proxy) {
+  // Received means either buffered or declared irrelevant by a GAP
+  while (proxy.isReceived(proxy.expectedSN)) {
+    BufferedSample *sample = proxy.reorderBuffer.find(proxy.expectedSN);
+    if (sample != nullptr) {
+      SFR_LOG("Delivering buffered SN %u.%u\r\n", (int)sample->sn.high,
+              (int)sample->sn.low);
+      ReaderCacheChange change{sample->kind, proxy.remoteWriterGuid,
+                               sample->sn,   sample->data,
+                               sample->size, sample->buffer};
+      executeCallbacks(change, &proxy);
+      proxy.reorderBuffer.release(*sample);
     }
+    proxy.advanceExpectedSN(proxy.expectedSN + 1);
+  }
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::skipTo(WriterProxy &proxy,
+                                            const SequenceNumber_t &sn) {
+  // Whatever is missing before sn is lost for good, still hand out what we
+  // already have in order.
+  BufferedSample *sample = proxy.reorderBuffer.findFirst();
+  while (sample != nullptr && sample->sn < sn) {
+    ReaderCacheChange change{sample->kind, proxy.remoteWriterGuid,
+                             sample->sn,   sample->data,
+                             sample->size, sample->buffer};
+    executeCallbacks(change, &proxy);
+    proxy.reorderBuffer.release(*sample);
+    sample = proxy.reorderBuffer.findFirst();
   }
+  proxy.advanceExpectedSN(sn);
+  deliverBufferedSamples(proxy);
 }
 
 template <class NetworkDriver>
@@ -122,74 +185,55 @@ bool StatefulReaderT<NetworkDriver>::onNewGapMessage(
 
   // Case 1: We are still waiting for messages before gapStart
   if (writer->expectedSN < msg.gapStart) {
-    PacketInfo info;
-    info.srcPort = m_srcPort;
-    info.destAddr = writer->remoteLocator.getIp4Address();
-    info.destPort = writer->remoteLocator.port;
-    rtps::MessageFactory::addHeader(info.buffer,
-                                    m_attributes.endpointGuid.prefix);
+    // Remember the irrelevant ones so they are not requested later on
+    markIrrelevant(*writer, msg);
     SequenceNumber_t last_valid = msg.gapStart;
     --last_valid;
-    auto missing_sns = writer->getMissing(writer->expectedSN, last_valid);
-    rtps::MessageFactory::addAckNack(info.buffer, msg.writerId, msg.readerId,
-                                     missing_sns, writer->getNextAckNackCount(),
-                                     false);
-    m_transport->sendPacket(info);
+    scheduleAckNack(*writer, last_valid);
     return true;
   }
 
   // Case 2: We are expecting a message between [gapStart; gapList.base -1]
   // Advance expectedSN beyond gapList.base
-  if (writer->expectedSN < msg.gapList.base) {
-    auto before = writer->expectedSN;
-    writer->expectedSN = msg.gapList.base;
-
-    // writer->expectedSN++;
-
-    // Advance expectedSN to first unset bit
-    for (uint32_t bit = 0; bit < SNS_MAX_NUM_BITS;
-         writer->expectedSN++, bit++) {
-      if (!msg.gapList.isSet(bit)) {
-        break;
-      }
-    }
+  const bool expectedBeforeGapListBase = writer->expectedSN < msg.gapList.base;
+  skipTo(*writer, msg.gapList.base);
+  markIrrelevant(*writer, msg);
+  deliverBufferedSamples(*writer);
 
+  if (expectedBeforeGapListBase) {
     return true;
+  }
 
-  }else{
-
-	  // Case 3: We are expecting a sequence number beyond gap list base,
-	  // check if we need to update expectedSN
-	  auto i = msg.gapList.base;
-	  for(uint32_t bit = 0; bit < SNS_MAX_NUM_BITS; i++, bit++){
-		if(i < writer->expectedSN){
-			continue;
-		}
-
-		if(msg.gapList.isSet(bit)){
-			writer->expectedSN++;
-		}else{
-		  PacketInfo info;
-		  info.srcPort = m_srcPort;
-		  info.destAddr = writer->remoteLocator.getIp4Address();
-		  info.destPort = writer->remoteLocator.port;
-		  rtps::MessageFactory::addHeader(info.buffer,
-											m_attributes.endpointGuid.prefix);
-		  SequenceNumberSet set;
-		  set.base = writer->expectedSN;
-		  set.numBits = 1;
-		  set.bitMap[0] = set.bitMap[0] |= uint32_t{1} << 31;
-		  rtps::MessageFactory::addAckNack(info.buffer, msg.writerId, msg.readerId,
-											 set, writer->getNextAckNackCount(),
-											 false);
-		  m_transport->sendPacket(info);
-
-		  return true;
-		}
-	  }
+  // Case 3: We were expecting a sequence number beyond gap list base,
+  // request what is still missing in the range covered by the gap list
+  if (msg.gapList.numBits == 0) {
+    return false;
+  }
+  SequenceNumber_t lastInGapList = msg.gapList.base + (msg.gapList.numBits - 1);
+  if (lastInGapList < writer->expectedSN) {
+    return false;
+  }
 
+  scheduleAckNack(*writer, lastInGapList);
+  return true;
+}
 
-    return false;
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::markIrrelevant(WriterProxy &proxy,
+                                                    const SubmessageGap &msg) {
+  SequenceNumber_t sn =
+      proxy.expectedSN < msg.gapStart ? msg.gapStart : proxy.expectedSN;
+  for (; sn < msg.gapList.base; ++sn) {
+    if (!proxy.markReceived(sn)) {
+      return;
+    }
+  }
+
+  for (uint32_t bit = msg.gapList.findNextSet(0); bit < SNS_MAX_NUM_BITS;
+       bit = msg.gapList.findNextSet(bit + 1)) {
+    if (!proxy.markReceived(msg.gapList.base + bit)) {
+      return;
+    }
   }
 }
 
@@ -200,9 +244,6 @@ bool StatefulReaderT<NetworkDriver>::onNewHeartbeat(
   if (!m_is_initialized_) {
     return false;
   }
-  PacketInfo info;
-  info.srcPort = m_srcPort;
-
   Guid_t writerProxyGuid;
   writerProxyGuid.prefix = sourceGuidPrefix;
   writerProxyGuid.entityId = msg.writerId;
@@ -220,26 +261,137 @@ bool StatefulReaderT<NetworkDriver>::onNewHeartbeat(
 
   if (writer->expectedSN < msg.firstSN) {
     SFR_LOG("expectedSN < firstSN, advancing expectedSN");
-    writer->expectedSN = msg.firstSN;
+    skipTo(*writer, msg.firstSN);
   }
 
   writer->hbCount.value = msg.count.value;
+  scheduleAckNack(*writer, msg.lastSN);
+  return true;
+}
+
+template <class NetworkDriver>
+bool StatefulReaderT<NetworkDriver>::onNewHeartbeatFrag(
+    const SubmessageHeartbeatFrag &msg, const GuidPrefix_t &sourceGuidPrefix) {
+  Lock lock{m_proxies_mutex};
+  if (!m_is_initialized_) {
+    return false;
+  }
+  Guid_t writerProxyGuid;
+  writerProxyGuid.prefix = sourceGuidPrefix;
+  writerProxyGuid.entityId = msg.writerId;
+  WriterProxy *writer = getProxy(writerProxyGuid);
+  if (writer == nullptr || writer->isReceived(msg.writerSN)) {
+    return false;
+  }
+
+  FragmentNumberSet missing;
+  if (!m_fragments.getMissingFragments(writerProxyGuid, msg.writerSN,
+                                       msg.lastFragmentNum.value, missing)) {
+    return true;
+  }
+
+  // Sent right away, fragments are only kept for a short time
+  PacketInfo info;
+  info.srcPort = m_srcPort;
   info.destAddr = writer->remoteLocator.getIp4Address();
   info.destPort = writer->remoteLocator.port;
   rtps::MessageFactory::addHeader(info.buffer,
                                   m_attributes.endpointGuid.prefix);
-  auto missing_sns = writer->getMissing(msg.firstSN, msg.lastSN);
-  bool final_flag = (missing_sns.numBits == 0);
-  rtps::MessageFactory::addAckNack(info.buffer, msg.writerId, msg.readerId,
-                                   missing_sns, writer->getNextAckNackCount(),
-                                   final_flag);
-
-  SFR_LOG("Sending acknack base %u bits %u .\n", (int)missing_sns.base.low,
-          (int)missing_sns.numBits);
+  ++writer->nackFragCount.value;
+  rtps::MessageFactory::addNackFrag(
+      info.buffer, msg.writerId, m_attributes.endpointGuid.entityId,
+      msg.writerSN, missing, writer->nackFragCount);
+
+  SFR_LOG("Requesting %u missing fragments.\n", missing.numBits);
   m_transport->sendPacket(info);
   return true;
 }
 
+template <class NetworkDriver>
+bool StatefulReaderT<NetworkDriver>::isFragmentRelevant(
+    const Guid_t &writerGuid, const SequenceNumber_t &sn) {
+  const WriterProxy *writer = getProxy(writerGuid);
+  return writer != nullptr && !writer->isReceived(sn);
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::scheduleAckNack(
+    WriterProxy &proxy, const SequenceNumber_t &lastSN) {
+  if (proxy.ackNackPending) {
+    // A request is already on its way, extend it instead of adding another
+    if (proxy.ackNackLastSN < lastSN) {
+      proxy.ackNackLastSN = lastSN;
+    }
+    Diagnostics::StatefulReader::sfr_acknacks_merged++;
+    return;
+  }
+
+  proxy.ackNackPending = true;
+  proxy.ackNackScheduled = xTaskGetTickCount();
+  proxy.ackNackLastSN = lastSN;
+}
+
+template <class NetworkDriver>
+bool StatefulReaderT<NetworkDriver>::getDueAckNackDestination(
+    TickType_t now, LocatorIPv4 &destination, TickType_t &waitTicks) {
+  constexpr TickType_t delay =
+      pdMS_TO_TICKS(Config::SFR_HEARTBEAT_RESPONSE_DELAY_MS);
+  waitTicks = 0;
+  Lock lock{m_proxies_mutex};
+  if (!m_is_initialized_) {
+    return false;
+  }
+
+  for (const auto &proxy : m_proxies) {
+    if (!proxy.ackNackPending) {
+      continue;
+    }
+    const TickType_t elapsed = now - proxy.ackNackScheduled;
+    if (elapsed >= delay) {
+      destination = proxy.remoteLocator;
+      return true;
+    }
+    if (waitTicks == 0 || delay - elapsed < waitTicks) {
+      waitTicks = delay - elapsed;
+    }
+  }
+  return false;
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::appendDueAckNacks(
+    TickType_t now, const LocatorIPv4 &destination, PBufWrapper &buffer) {
+  constexpr TickType_t delay =
+      pdMS_TO_TICKS(Config::SFR_HEARTBEAT_RESPONSE_DELAY_MS);
+  Lock lock{m_proxies_mutex};
+  if (!m_is_initialized_) {
+    return;
+  }
+
+  for (auto &proxy : m_proxies) {
+    if (!proxy.ackNackPending || !(proxy.remoteLocator == destination) ||
+        now - proxy.ackNackScheduled < delay) {
+      continue;
+    }
+
+    auto missing_sns = proxy.getMissing(proxy.expectedSN, proxy.ackNackLastSN);
+    if (buffer.spaceUsed() + SubmessageAckNack::getRawSize(missing_sns) >
+        Config::MAX_RTPS_MESSAGE_SIZE) {
+      // Stays pending and goes into the next message
+      return;
+    }
+
+    const bool final_flag = (missing_sns.numBits == 0);
+    rtps::MessageFactory::addAckNack(
+        buffer, proxy.remoteWriterGuid.entityId,
+        m_attributes.endpointGuid.entityId, missing_sns,
+        proxy.getNextAckNackCount(), final_flag);
+    proxy.ackNackPending = false;
+    SFR_LOG("Sending acknack base %u bits %u .\n", (int)missing_sns.base.low,
+            (int)missing_sns.numBits);
+  }
+}
+
 template <class NetworkDriver>
 bool StatefulReaderT<NetworkDriver>::sendPreemptiveAckNack(
     const WriterProxy &writer) {
@@ -28,14 +28,28 @@ public:
   const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
                                DataSize_t size, bool inLineQoS = false,
                                bool markDisposedAfterWrite = false) override;
+  using Writer::newChange;
 
   bool removeFromHistory(const SequenceNumber_t &s);
   void setAllChangesToUnsent() override;
   void onNewAckNack(const SubmessageAckNack &msg,
                     const GuidPrefix_t &sourceGuidPrefix) override;
+  void onNewNackFrag(const SubmessageNackFrag &msg,
+                     const GuidPrefix_t &sourceGuidPrefix) override;
+  void sendDueRepairs(TickType_t now, TickType_t &waitTicks) override;
   void reset() override;
+  //! New readers get a key frame first if delta encoding is enabled
+  bool addNewMatchedReader(const ReaderProxy &newProxy) override;
+  //! See WriterOptions::deltaKeyFrameInterval
+  void setDeltaEncoding(uint16_t keyFrameInterval);
   void updateChangeKind(SequenceNumber_t &sequence_number);
 
+protected:
+  const CacheChange *addChangeToHistory(ChangeKind_t kind,
+                                        CacheChange &&change, bool inLineQoS,
+                                        bool markDisposedAfterWrite) override;
+  void sendPacket(PacketInfo &packet) override;
+
 private:
   NetworkDriver *m_transport;
 
@@ -58,6 +72,24 @@ private:
   bool m_running = true;
   bool m_thread_running = false;
 
+  //! Taken before m_mutex by everything adding to the history
+  SemaphoreHandle_t m_producerMutex = nullptr;
+
+  // Delta encoding, the plain payload of a sample is the base of the next.
+  // A GAP means a reader lost its base, so a key frame follows.
+  uint16_t m_deltaKeyFrameInterval = 0;
+  uint16_t m_samplesSinceKeyFrame = 0;
+  bool m_forceKeyFrame = false;
+  PBufWrapper m_deltaBase;
+  SequenceNumber_t m_deltaBaseSN;
+  //! Readers matched later start at the latest key frame in the history
+  SequenceNumber_t m_lastKeyFrameSN = {0, 0};
+  //! Replaces the payload by a key frame or a delta. Needs the mutex.
+  void encodeDelta(CacheChange &change);
+
+  //! Sends the change at m_nextSequenceNumberToSend to all readers. Returns
+  //! false if there is none or the flow controllers defer it.
+  bool sendNextChange();
   bool sendData(const ReaderProxy &reader, const CacheChange *next);
   bool sendDataWRMulticast(const ReaderProxy &reader, const CacheChange *next);
   static void hbFunctionJumppad(void *thisPointer);
@@ -65,6 +97,38 @@ private:
   void sendHeartBeat();
   void sendGap(const ReaderProxy &reader, const SequenceNumber_t &firstMissing,
                const SequenceNumber_t &nextValid);
+
+  // Readers whose NACK response delay passed. Only valid while
+  // sendDueRepairs() holds the mutex.
+  std::array<ReaderProxy *, Config::NUM_READER_PROXIES_PER_WRITER>
+      m_dueRepairs{};
+  uint8_t m_numDueRepairs = 0;
+
+  static bool isRequested(const ReaderProxy &reader,
+                          const SequenceNumber_t &sn);
+  static bool isSameMulticastGroup(const ReaderProxy &first,
+                                   const ReaderProxy &second);
+  //! True if enough due readers of the group of reader requested sn
+  bool isRepairedByMulticast(const ReaderProxy &reader,
+                             const SequenceNumber_t &sn) const;
+  void sendMulticastRepairs(const ReaderProxy &firstOfGroup);
+  void sendUnicastRepairs(const ReaderProxy &reader);
+
+  // Repairs are coalesced into as few messages as the MTU allows. A message
+  // is started on demand and sent once the next submessage would not fit
+  // anymore.
+  void reserveRepairSpace(const LocatorIPv4 &destination, PacketInfo &info,
+                          DataSize_t size);
+  void addRepairGap(const ReaderProxy &reader, PacketInfo &info,
+                    const SequenceNumber_t &gapStart,
+                    const SequenceNumberSet &gapList);
+  void flushRepairMessage(PacketInfo &info);
+  //! Fragmented samples are repaired on their own, followed by a
+  //! HEARTBEAT_FRAG so the reader can request what is still missing
+  void sendRepairFragments(const LocatorIPv4 &destination,
+                           const EntityId_t &readerId,
+                           const CacheChange &change,
+                           const FragmentNumberSet *requested);
 };
 
 using StatefulWriter = StatefulWriterT<UdpDriver>;
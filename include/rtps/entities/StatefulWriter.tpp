@@ -9,9 +9,12 @@
 
 #include "lwip/sys.h"
 #include "rtps/entities/StatefulWriter.h"
+#include "rtps/messages/Encapsulation.h"
 #include "rtps/messages/MessageFactory.h"
 #include "rtps/messages/MessageTypes.h"
+#include "rtps/utils/Diagnostics.h"
 #include "rtps/utils/Log.h"
+#include "rtps/utils/XorDelta.h"
 #include <cstring>
 #include <stdio.h>
 
@@ -57,6 +60,10 @@ bool StatefulWriterT<NetworkDriver>::init(TopicData attributes,
       return false;
     }
   }
+  if (m_producerMutex == nullptr && !createMutex(&m_producerMutex)) {
+    SFW_LOG("Failed to create mutex.\n");
+    return false;
+  }
 
   m_attributes = attributes;
 
@@ -67,6 +74,7 @@ bool StatefulWriterT<NetworkDriver>::init(TopicData attributes,
 
   m_nextSequenceNumberToSend = {0, 1};
   m_proxies.clear();
+  m_multicastGroups.clear();
 
   m_transport = &driver;
   m_history.clear();
@@ -104,6 +112,7 @@ bool StatefulWriterT<NetworkDriver>::init(TopicData attributes,
 
 template <class NetworkDriver> void StatefulWriterT<NetworkDriver>::reset() {
   m_is_initialized_ = false;
+  m_deltaBase.destroy();
   // TODO
 }
 
@@ -116,11 +125,61 @@ const rtps::CacheChange *StatefulWriterT<NetworkDriver>::newChange(
     return nullptr;
   }
 
+  CacheChange change;
+  if (!change.setPayload(data, size)) {
+    SFW_LOG("Failed to allocate payload of %u bytes.\r\n", (unsigned)size);
+    return nullptr;
+  }
+  return addChangeToHistory(kind, std::move(change), inLineQoS,
+                            markDisposedAfterWrite);
+}
+
+template <class NetworkDriver>
+const rtps::CacheChange *StatefulWriterT<NetworkDriver>::addChangeToHistory(
+    ChangeKind_t kind, CacheChange &&change, bool inLineQoS,
+    bool markDisposedAfterWrite) {
+  INIT_GUARD()
+  if (isIrrelevant(kind)) {
+    return nullptr;
+  }
+
+  const bool encodeDeltas = m_deltaKeyFrameInterval != 0 && !m_conflate;
+  if (!encodeDeltas) {
+    compressPayload(change);
+  }
+
+  // A delta refers to the sequence number of its base. Producers are
+  // serialized, so the change still gets the next one after compressing it
+  // without m_mutex.
+  Lock producerLock{m_producerMutex};
+  if (encodeDeltas) {
+    {
+      Lock lock{m_mutex};
+      if (!m_is_initialized_) {
+        return nullptr;
+      }
+      encodeDelta(change);
+    }
+    compressPayload(change);
+  }
+
   Lock lock{m_mutex};
   if (!m_is_initialized_) {
     return nullptr;
   }
 
+  if (m_conflate && !encodeDeltas && kind == ChangeKind_t::ALIVE &&
+      !markDisposedAfterWrite) {
+    // Overwrite the newest change while it is still waiting to be sent
+    const SequenceNumber_t lastSN = m_history.getLastUsedSequenceNumber();
+    const CacheChange *pending = m_history.getChangeBySN(lastSN);
+    if (!(lastSN < m_nextSequenceNumberToSend) && pending != nullptr &&
+        pending->kind == ChangeKind_t::ALIVE && !pending->disposeAfterWrite) {
+      Diagnostics::StatefulWriter::sfw_conflated_samples++;
+      return m_history.replaceChange(lastSN, std::move(change), inLineQoS);
+    }
+  }
+
   if (m_history.isFull()) {
     // Right now we drop elements anyway because we cannot detect non-responding
     // readers yet. return nullptr;
@@ -133,9 +192,9 @@ const rtps::CacheChange *StatefulWriterT<NetworkDriver>::newChange(
     SFW_LOG("History full! Dropping changes %s.\r\n", this->m_attributes.topicName);
   }
 
-  auto *result =
-      m_history.addChange(data, size, inLineQoS, markDisposedAfterWrite);
-  if (mp_threadPool != nullptr) {
+  auto *result = m_history.addChange(std::move(change), inLineQoS,
+                                     markDisposedAfterWrite);
+  if (mp_threadPool != nullptr && !m_batchInsert) {
     mp_threadPool->addWorkload(this);
   }
 
@@ -144,14 +203,183 @@ const rtps::CacheChange *StatefulWriterT<NetworkDriver>::newChange(
   return result;
 }
 
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::addNewMatchedReader(
+    const ReaderProxy &newProxy) {
+  // Waits for a delta that is being compressed, it is not in the history yet
+  Lock producerLock{m_producerMutex};
+  Lock lock{m_mutex};
+  if (m_deltaKeyFrameInterval == 0 || m_conflate) {
+    return Writer::addNewMatchedReader(newProxy);
+  }
+
+  // The reader starts at the latest key frame that is still in the history
+  // or the next sample, which is made a key frame
+  ReaderProxy proxy = newProxy;
+  if (m_lastKeyFrameSN == SequenceNumber_t{0, 0} ||
+      m_lastKeyFrameSN < m_history.getCurrentSeqNumMin()) {
+    proxy.firstDecodableSN =
+        ++SequenceNumber_t(m_history.getLastUsedSequenceNumber());
+    m_forceKeyFrame = true;
+  } else {
+    proxy.firstDecodableSN = m_lastKeyFrameSN;
+  }
+  return Writer::addNewMatchedReader(proxy);
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::setDeltaEncoding(
+    uint16_t keyFrameInterval) {
+  Lock lock{m_mutex};
+  m_deltaKeyFrameInterval = keyFrameInterval;
+  m_samplesSinceKeyFrame = 0;
+  m_forceKeyFrame = true;
+  m_deltaBase.destroy();
+  m_lastKeyFrameSN = SequenceNumber_t{0, 0};
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::encodeDelta(CacheChange &change) {
+  const pbuf *first =
+      change.hasInlinePayload() ? nullptr : change.data.firstElement;
+  const DataSize_t size = first != nullptr ? first->tot_len : 0;
+  const auto *data =
+      first != nullptr ? static_cast<const uint8_t *>(first->payload) : nullptr;
+  ucdrEndianness endianness;
+  // Whatever is sent as it is breaks the chain, the next one is a key frame
+  if (first == nullptr || first->len != size ||
+      size > UINT16_MAX - Encapsulation::DELTA_HEADER_SIZE ||
+      !Encapsulation::readHeader(data, size, endianness)) {
+    m_deltaBase.destroy();
+    return;
+  }
+
+  const DataSize_t keyFrameSize =
+      size - Encapsulation::HEADER_SIZE + Encapsulation::DELTA_HEADER_SIZE;
+  PBufWrapper encoded{pbuf_alloc(PBUF_TRANSPORT, keyFrameSize, PBUF_RAM)};
+  if (!encoded.isValid()) {
+    m_deltaBase.destroy();
+    return;
+  }
+  auto *out = static_cast<uint8_t *>(encoded.firstElement->payload);
+  const SequenceNumber_t sn = ++SequenceNumber_t(
+      m_history.getLastUsedSequenceNumber());
+  const DataSize_t bodySize = size - Encapsulation::HEADER_SIZE;
+
+  const bool keyFrameDue =
+      m_forceKeyFrame || !m_deltaBase.isValid() ||
+      m_deltaBase.firstElement->tot_len != size ||
+      ++SequenceNumber_t(m_deltaBaseSN) != sn ||
+      m_samplesSinceKeyFrame + 1u >= m_deltaKeyFrameInterval;
+  const DataSize_t overhead =
+      Encapsulation::DELTA_HEADER_SIZE - Encapsulation::HEADER_SIZE;
+  uint32_t deltaSize = 0;
+  // Capacity below the plain size, deltas that save nothing are dropped.
+  // Unchanged samples are sent as empty delta.
+  const bool isDelta =
+      !keyFrameDue && bodySize > overhead + 1 &&
+      XorDelta::encode(
+          static_cast<const uint8_t *>(m_deltaBase.firstElement->payload) +
+              Encapsulation::HEADER_SIZE,
+          data + Encapsulation::HEADER_SIZE, bodySize,
+          out + Encapsulation::DELTA_HEADER_SIZE, bodySize - overhead - 1,
+          deltaSize);
+
+  const SequenceNumber_t baseSN =
+      isDelta ? m_deltaBaseSN : SequenceNumber_t{0, 0};
+  memcpy(out, data, Encapsulation::HEADER_SIZE);
+  out[2] |= Encapsulation::OPTION_DELTA;
+  const uint32_t words[3] = {bodySize, static_cast<uint32_t>(baseSN.high),
+                             baseSN.low};
+  for (uint8_t i = 0; i < 3; ++i) {
+    for (uint8_t byte = 0; byte < 4; ++byte) {
+      out[Encapsulation::HEADER_SIZE + i * 4 + byte] =
+          static_cast<uint8_t>(words[i] >> (8 * byte));
+    }
+  }
+
+  if (isDelta) {
+    const DataSize_t deltaPayloadSize =
+        Encapsulation::DELTA_HEADER_SIZE + deltaSize;
+    // Shrinks in place, memory of PBUF_RAM is contiguous
+    pbuf_realloc(encoded.firstElement, deltaPayloadSize);
+    ++m_samplesSinceKeyFrame;
+    Diagnostics::StatefulWriter::sfw_delta_samples++;
+    Diagnostics::StatefulWriter::sfw_delta_bytes_saved +=
+        size - deltaPayloadSize;
+  } else {
+    memcpy(out + Encapsulation::DELTA_HEADER_SIZE,
+           data + Encapsulation::HEADER_SIZE, bodySize);
+    m_samplesSinceKeyFrame = 0;
+    m_forceKeyFrame = false;
+    m_lastKeyFrameSN = sn;
+    Diagnostics::StatefulWriter::sfw_key_frames++;
+  }
+
+  // The plain payload is kept as base for the next sample without a copy
+  m_deltaBase = std::move(change.data);
+  m_deltaBaseSN = sn;
+  change.data = std::move(encoded);
+}
+
 template <class NetworkDriver> void StatefulWriterT<NetworkDriver>::progress() {
   INIT_GUARD()
-  Lock lock{m_mutex};
-  CacheChange *next = m_history.getChangeBySN(m_nextSequenceNumberToSend);
-  if (next != nullptr) {
+  // Drains everything that is pending, a batch is scheduled only once
+  bool sent = false;
+  while (sendNextChange()) {
+    sent = true;
+  }
+
+  if (sent) {
+    Lock lock{m_mutex};
+    sendHeartBeat();
+  } else {
+    SFW_LOG("Couldn't get a CacheChange with SN (%i,%u)\n",
+            m_nextSequenceNumberToSend.high, m_nextSequenceNumberToSend.low);
+  }
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::sendNextChange() {
+  // Reserve the budget outside of the lock, the participant controller is
+  // shared with other writers
+  uint32_t pendingBytes = 0;
+  uint32_t pendingPackets = 0;
+  {
+    Lock lock{m_mutex};
+    const CacheChange *pending =
+        m_history.getChangeBySN(m_nextSequenceNumberToSend);
+    if (pending != nullptr) {
+      for (const auto &proxy : m_proxies) {
+        if (proxy.localReader == nullptr &&
+            (m_enforceUnicast || proxy.useMulticast ||
+             !proxy.suppressUnicast)) {
+          ++pendingPackets;
+        }
+      }
+      pendingBytes =
+          pendingPackets * getDataPacketSize(pending->getDataSize());
+    }
+  }
+  if (pendingPackets != 0 && !paceTransmission(pendingBytes, pendingPackets)) {
+    // Resumed by the writer thread once the budget allows it
+    return false;
+  }
+
+  // Local readers run their callbacks, they get the sample after unlocking
+  LocalDelivery localDelivery;
+  {
+    Lock lock{m_mutex};
+    CacheChange *next = m_history.getChangeBySN(m_nextSequenceNumberToSend);
+    if (next == nullptr) {
+      return false;
+    }
+    Diagnostics::StatefulWriter::sfw_data_bytes_sent += pendingBytes;
     uint32_t i = 0;
     for (const auto &proxy : m_proxies) {
-      if (!m_enforceUnicast) {
+      if (proxy.localReader != nullptr) {
+        addLocalDelivery(localDelivery, proxy, *next);
+      } else if (!m_enforceUnicast) {
         sendDataWRMulticast(proxy, next);
       } else {
         i++;
@@ -186,12 +414,10 @@ template <class NetworkDriver> void StatefulWriterT<NetworkDriver>::progress() {
     }
 
     ++m_nextSequenceNumberToSend;
-    sendHeartBeat();
-
-  } else {
-    SFW_LOG("Couldn't get a CacheChange with SN (%i,%u)\n",
-            m_nextSequenceNumberToSend.high, m_nextSequenceNumberToSend.low);
   }
+
+  deliverLocally(localDelivery);
+  return true;
 }
 
 template <class NetworkDriver>
@@ -260,56 +486,364 @@ void StatefulWriterT<NetworkDriver>::onNewAckNack(
     return;
   }
 
-  // Requesting smaller SN than minimum sequence number -> sendGap
-  if (msg.readerSNState.base < m_history.getCurrentSeqNumMin()) {
-    sendGap(*reader, msg.readerSNState.base, m_history.getCurrentSeqNumMin());
+  SFW_LOG("Received non-preemptive acknack with %u bits set.\r\n",
+          msg.readerSNState.numBits);
+  if (msg.readerSNState.findNextSet(0) == SNS_MAX_NUM_BITS &&
+      !(msg.readerSNState.base < m_history.getCurrentSeqNumMin())) {
+    // Positive acknowledgement, earlier requests are obsolete as well
+    reader->repairPending = false;
     return;
   }
 
-  SFW_LOG("Received non-preemptive acknack with %u bits set.\r\n",
-          msg.readerSNState.numBits);
-  for (uint32_t i = 0; i < msg.readerSNState.numBits &&
-                       nextSN <= m_history.getLastUsedSequenceNumber();
-       ++i, ++nextSN) {
+  // The latest ACKNACK describes the state of the reader completely, it
+  // replaces requests that are still waiting for the NACK response delay
+  if (reader->repairPending) {
+    Diagnostics::StatefulWriter::sfw_nacks_merged++;
+  } else {
+    reader->repairPending = true;
+    reader->repairScheduled = xTaskGetTickCount();
+  }
+  reader->requestedRepairs = msg.readerSNState;
+}
 
-    if (msg.readerSNState.isSet(i)) {
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::onNewNackFrag(
+    const SubmessageNackFrag &msg, const GuidPrefix_t &sourceGuidPrefix) {
+  INIT_GUARD()
+  Lock lock{m_mutex};
+  if (!m_is_initialized_) {
+    return;
+  }
 
-      SFW_LOG("Looking for change %u | Bit %u", nextSN.low, i);
-      const rtps::CacheChange *cache = m_history.getChangeBySN(nextSN);
+  ReaderProxy *reader = nullptr;
+  for (auto &proxy : m_proxies) {
+    if (proxy.remoteReaderGuid.prefix == sourceGuidPrefix &&
+        proxy.remoteReaderGuid.entityId == msg.readerId) {
+      reader = &proxy;
+      break;
+    }
+  }
 
-      // We still have the cache, send DATA
-      if (cache != nullptr) {
-        if (cache->disposeAfterWrite) {
-          SFW_LOG("SERVING FROM DISPOSE AFTER WRITE CACHE\r\n");
-        }
-        sendData(*reader, cache);
-      } else {
-        SFW_LOG("> Change not found, search for next valid SN %u \r\n",
-                nextSN.low);
-        // Cache not found, look for next valid SN
-        rtps::SequenceNumber_t gapBegin = nextSN;
-        rtps::CacheChange *nextValidChange = nullptr;
-        uint32_t j = i + 1;
-        for (++nextSN; nextSN <= m_history.getLastUsedSequenceNumber();
-             ++nextSN, ++j) {
-          nextValidChange = m_history.getChangeBySN(nextSN);
-          if (nextValidChange != nullptr) {
-            break;
-          }
-        }
-        if (nextValidChange == nullptr) {
-          sendGap(*reader, gapBegin, nextSN);
-          return;
-        } else {
-          sendGap(*reader, gapBegin, nextValidChange->sequenceNumber);
+  // Repeated NACK_FRAGs for the same HEARTBEAT_FRAG are answered once
+  if (reader == nullptr || msg.count.value <= reader->nackFragCount.value) {
+    return;
+  }
+  reader->nackFragCount = msg.count;
+
+  const CacheChange *cache = m_history.getChangeBySN(msg.writerSN);
+  if (cache == nullptr || !needsFragmentation(*cache)) {
+    // Gone or never fragmented, the next ACKNACK triggers a GAP or DATA
+    return;
+  }
+  sendRepairFragments(reader->remoteLocator, reader->remoteReaderGuid.entityId,
+                      *cache, &msg.fragmentNumberState);
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::sendDueRepairs(TickType_t now,
+                                                    TickType_t &waitTicks) {
+  constexpr TickType_t delay =
+      pdMS_TO_TICKS(Config::SFW_NACK_RESPONSE_DELAY_MS);
+  waitTicks = 0;
+  Lock lock{m_mutex};
+  if (!m_is_initialized_) {
+    return;
+  }
+
+  m_numDueRepairs = 0;
+  for (auto &proxy : m_proxies) {
+    if (!proxy.repairPending) {
+      continue;
+    }
+    const TickType_t elapsed = now - proxy.repairScheduled;
+    if (elapsed < delay) {
+      if (waitTicks == 0 || delay - elapsed < waitTicks) {
+        waitTicks = delay - elapsed;
+      }
+      continue;
+    }
+    proxy.repairPending = false;
+    m_dueRepairs[m_numDueRepairs++] = &proxy;
+  }
+
+  if (m_numDueRepairs == 0 || m_history.isEmpty()) {
+    // Readers ask again with the next heartbeat
+    return;
+  }
+
+  // One multicast message per group, sent by the first reader of the group
+  for (uint8_t i = 0; i < m_numDueRepairs; ++i) {
+    const ReaderProxy &reader = *m_dueRepairs[i];
+    if (reader.remoteMulticastLocator.kind !=
+        LocatorKind_t::LOCATOR_KIND_UDPv4) {
+      continue;
+    }
+    bool isFirstOfGroup = true;
+    for (uint8_t j = 0; j < i; ++j) {
+      if (isSameMulticastGroup(*m_dueRepairs[j], reader)) {
+        isFirstOfGroup = false;
+        break;
+      }
+    }
+    if (isFirstOfGroup) {
+      sendMulticastRepairs(reader);
+    }
+  }
+
+  for (uint8_t i = 0; i < m_numDueRepairs; ++i) {
+    sendUnicastRepairs(*m_dueRepairs[i]);
+  }
+  m_numDueRepairs = 0;
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::isRequested(const ReaderProxy &reader,
+                                                 const SequenceNumber_t &sn) {
+  const SequenceNumberSet &requested = reader.requestedRepairs;
+  if (sn < requested.base) {
+    return false;
+  }
+  const uint64_t bit = sn - requested.base;
+  return bit < requested.numBits && requested.isSet(static_cast<uint32_t>(bit));
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::isSameMulticastGroup(
+    const ReaderProxy &first, const ReaderProxy &second) {
+  return first.remoteMulticastLocator.kind ==
+             LocatorKind_t::LOCATOR_KIND_UDPv4 &&
+         first.remoteMulticastLocator == second.remoteMulticastLocator;
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::isRepairedByMulticast(
+    const ReaderProxy &reader, const SequenceNumber_t &sn) const {
+  if (reader.remoteMulticastLocator.kind != LocatorKind_t::LOCATOR_KIND_UDPv4) {
+    return false;
+  }
+  uint8_t numRequesters = 0;
+  for (uint8_t i = 0; i < m_numDueRepairs; ++i) {
+    if (isSameMulticastGroup(*m_dueRepairs[i], reader) &&
+        isRequested(*m_dueRepairs[i], sn)) {
+      ++numRequesters;
+    }
+  }
+  return numRequesters >= Config::SFW_MULTICAST_REPAIR_MIN_READERS;
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::sendMulticastRepairs(
+    const ReaderProxy &firstOfGroup) {
+  const SequenceNumber_t &lastUsed = m_history.getLastUsedSequenceNumber();
+  PacketInfo info;
+  info.buffer.setPool(getTransmitPool());
+
+  for (uint8_t i = 0; i < m_numDueRepairs; ++i) {
+    const ReaderProxy &member = *m_dueRepairs[i];
+    if (!isSameMulticastGroup(member, firstOfGroup)) {
+      continue;
+    }
+
+    const SequenceNumberSet &requested = member.requestedRepairs;
+    for (uint32_t bit = requested.findNextSet(0); bit < SNS_MAX_NUM_BITS;
+         bit = requested.findNextSet(bit + 1)) {
+      const SequenceNumber_t requestedSN = requested.base + bit;
+      if (lastUsed < requestedSN) {
+        break;
+      }
+
+      // Each sequence number is sent once, for the first member asking for it
+      bool alreadyAdded = false;
+      for (uint8_t j = 0; j < i; ++j) {
+        if (isSameMulticastGroup(*m_dueRepairs[j], firstOfGroup) &&
+            isRequested(*m_dueRepairs[j], requestedSN)) {
+          alreadyAdded = true;
+          break;
         }
-        // sendData(nullptr, nextValidChange);
-        nextSN = nextValidChange->sequenceNumber;
-        --nextSN;
-        i = --j;
       }
+      const rtps::CacheChange *cache = m_history.getChangeBySN(requestedSN);
+      if (alreadyAdded || cache == nullptr ||
+          !isRepairedByMulticast(member, requestedSN)) {
+        continue;
+      }
+      if (needsFragmentation(*cache)) {
+        sendRepairFragments(firstOfGroup.remoteMulticastLocator,
+                            ENTITYID_UNKNOWN, *cache, nullptr);
+        Diagnostics::StatefulWriter::sfw_multicast_repairs++;
+        continue;
+      }
+
+      reserveRepairSpace(firstOfGroup.remoteMulticastLocator, info,
+                         SubmessageData::getRawSize() +
+                             cache->getDataSize());
+      MessageFactory::addSubMessageData(info.buffer, *cache,
+                                        m_attributes.endpointGuid.entityId,
+                                        ENTITYID_UNKNOWN, true);
+      Diagnostics::StatefulWriter::sfw_multicast_repairs++;
     }
   }
+
+  flushRepairMessage(info);
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::sendUnicastRepairs(
+    const ReaderProxy &reader) {
+  const SequenceNumberSet &requested = reader.requestedRepairs;
+  const SequenceNumber_t &base = requested.base;
+  const SequenceNumber_t &lastUsed = m_history.getLastUsedSequenceNumber();
+  // Deltas the reader cannot decode are treated as if they were gone
+  SequenceNumber_t seqNumMin = m_history.getCurrentSeqNumMin();
+  if (seqNumMin < reader.firstDecodableSN) {
+    seqNumMin = reader.firstDecodableSN;
+  }
+  PacketInfo info;
+  info.buffer.setPool(getTransmitPool());
+
+  // Everything that cannot be served anymore is announced first, using as few
+  // GAP submessages as the bitmap allows. Requesting smaller SNs than the
+  // minimum in the history is covered by the contiguous part.
+  bool hasGap = false;
+  SequenceNumber_t gapStart;
+  SequenceNumberSet gapList;
+  if (base < seqNumMin) {
+    hasGap = true;
+    gapStart = base;
+    gapList.base = seqNumMin;
+  }
+
+  for (uint32_t bit = requested.findNextSet(0); bit < SNS_MAX_NUM_BITS;
+       bit = requested.findNextSet(bit + 1)) {
+    const SequenceNumber_t requestedSN = base + bit;
+    if (lastUsed < requestedSN) {
+      break;
+    }
+    if (requestedSN < seqNumMin ||
+        m_history.getChangeBySN(requestedSN) != nullptr) {
+      continue;
+    }
+
+    SFW_LOG("> Change %u not found, adding it to GAP \r\n", requestedSN.low);
+    if (hasGap && gapList.numBits == 0 && requestedSN == gapList.base) {
+      ++gapList.base;
+      continue;
+    }
+    if (hasGap) {
+      const uint64_t offset = requestedSN - gapList.base;
+      if (offset < SNS_MAX_NUM_BITS) {
+        gapList.set(static_cast<uint32_t>(offset));
+        gapList.numBits = static_cast<uint32_t>(offset) + 1;
+        continue;
+      }
+      addRepairGap(reader, info, gapStart, gapList);
+    }
+
+    hasGap = true;
+    gapStart = requestedSN;
+    gapList = SequenceNumberSet{requestedSN + 1};
+  }
+
+  if (hasGap) {
+    addRepairGap(reader, info, gapStart, gapList);
+  }
+
+  // Afterwards all DATA that is still available and not sent via multicast,
+  // in the same message(s)
+  for (uint32_t bit = requested.findNextSet(0); bit < SNS_MAX_NUM_BITS;
+       bit = requested.findNextSet(bit + 1)) {
+    const SequenceNumber_t requestedSN = base + bit;
+    if (lastUsed < requestedSN) {
+      break;
+    }
+
+    const rtps::CacheChange *cache = m_history.getChangeBySN(requestedSN);
+    if (cache == nullptr || requestedSN < seqNumMin ||
+        isRepairedByMulticast(reader, requestedSN)) {
+      continue;
+    }
+    if (cache->disposeAfterWrite) {
+      SFW_LOG("SERVING FROM DISPOSE AFTER WRITE CACHE\r\n");
+    }
+    if (needsFragmentation(*cache)) {
+      sendRepairFragments(reader.remoteLocator,
+                          reader.remoteReaderGuid.entityId, *cache, nullptr);
+      continue;
+    }
+
+    reserveRepairSpace(reader.remoteLocator, info,
+                       SubmessageData::getRawSize() + cache->getDataSize());
+    // The payload is copied as the message is extended afterwards, which
+    // would otherwise modify the pbuf chain owned by the history
+    MessageFactory::addSubMessageData(info.buffer, *cache,
+                                      m_attributes.endpointGuid.entityId,
+                                      reader.remoteReaderGuid.entityId, true);
+  }
+
+  flushRepairMessage(info);
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::reserveRepairSpace(
+    const LocatorIPv4 &destination, PacketInfo &info, DataSize_t size) {
+  if (info.buffer.isValid() &&
+      info.buffer.spaceUsed() + size > Config::MAX_RTPS_MESSAGE_SIZE) {
+    flushRepairMessage(info);
+  }
+
+  if (!info.buffer.isValid()) {
+    // Repairs must not overtake DATA the aggregator still holds back
+    flushAggregatedData(destination);
+    info.srcPort = m_srcPort;
+    MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
+    MessageFactory::addSubMessageTimeStamp(info.buffer);
+
+    // Just usable for IPv4
+    info.destAddr = destination.getIp4Address();
+    info.destPort = (Ip4Port_t)destination.port;
+  }
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::addRepairGap(
+    const ReaderProxy &reader, PacketInfo &info,
+    const SequenceNumber_t &gapStart, const SequenceNumberSet &gapList) {
+  m_forceKeyFrame = true;
+  reserveRepairSpace(reader.remoteLocator, info,
+                     SubmessageGap::getRawSize(gapList));
+  MessageFactory::addSubmessageGap(
+      info.buffer, m_attributes.endpointGuid.entityId,
+      reader.remoteReaderGuid.entityId, gapStart, gapList);
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::flushRepairMessage(PacketInfo &info) {
+  if (!info.buffer.isValid()) {
+    return;
+  }
+
+  m_transport->sendPacket(info);
+  const uint32_t repairBytes = info.buffer.spaceUsed();
+  Diagnostics::StatefulWriter::sfw_repair_bytes_sent += repairBytes;
+  // Repairs are sent from the receive path and must not block it, but
+  // they still use up the budget of new data
+  paceTransmission(repairBytes, 1, false);
+  info.buffer.destroy();
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::sendRepairFragments(
+    const LocatorIPv4 &destination, const EntityId_t &readerId,
+    const CacheChange &change, const FragmentNumberSet *requested) {
+  flushAggregatedData(destination);
+  const uint32_t repairBytes =
+      sendFragments(destination, readerId, change, requested, true);
+  Diagnostics::StatefulWriter::sfw_repair_bytes_sent += repairBytes;
+  paceTransmission(repairBytes, 1, false);
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::sendPacket(PacketInfo &packet) {
+  m_transport->sendPacket(packet);
 }
 
 template <class NetworkDriver>
@@ -323,11 +857,21 @@ template <class NetworkDriver>
 bool StatefulWriterT<NetworkDriver>::sendData(const ReaderProxy &reader,
                                               const CacheChange *next) {
   INIT_GUARD()
+  if (needsFragmentation(*next)) {
+    sendFragments(reader.remoteLocator, reader.remoteReaderGuid.entityId,
+                  *next, nullptr, true);
+    return true;
+  }
+  if (aggregateData(reader.remoteLocator, *next,
+                    reader.remoteReaderGuid.entityId)) {
+    return true;
+  }
   // TODO smarter packaging e.g. by creating MessageStruct and serialize after
   // adjusting values Reusing the pbuf is not possible. See
   // https://www.nongnu.org/lwip/2_0_x/raw_api.html (Zero-Copy MACs)
 
   PacketInfo info;
+  info.buffer.setPool(getTransmitPool());
   info.srcPort = m_srcPort;
 
   MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
@@ -339,9 +883,9 @@ bool StatefulWriterT<NetworkDriver>::sendData(const ReaderProxy &reader,
   info.destAddr = locator.getIp4Address();
   info.destPort = (Ip4Port_t)locator.port;
 
-  MessageFactory::addSubMessageData(
-      info.buffer, next->data, next->inLineQoS, next->sequenceNumber,
-      m_attributes.endpointGuid.entityId, reader.remoteReaderGuid.entityId);
+  MessageFactory::addSubMessageData(info.buffer, *next,
+                                    m_attributes.endpointGuid.entityId,
+                                    reader.remoteReaderGuid.entityId);
   m_transport->sendPacket(info);
 
   return true;
@@ -356,7 +900,10 @@ void StatefulWriterT<NetworkDriver>::sendGap(
   // adjusting values Reusing the pbuf is not possible. See
   // https://www.nongnu.org/lwip/2_0_x/raw_api.html (Zero-Copy MACs)
 
+  // The reader skips samples, the next delta might refer to one of them
+  m_forceKeyFrame = true;
   PacketInfo info;
+  info.buffer.setPool(getTransmitPool());
   info.srcPort = m_srcPort;
 
   MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
@@ -371,6 +918,7 @@ void StatefulWriterT<NetworkDriver>::sendGap(
   MessageFactory::addSubmessageGap(
       info.buffer, m_attributes.endpointGuid.entityId,
       reader.remoteReaderGuid.entityId, firstMissing, nextValid);
+  flushAggregatedData(locator);
   m_transport->sendPacket(info);
 }
 
@@ -380,7 +928,24 @@ bool StatefulWriterT<NetworkDriver>::sendDataWRMulticast(
   INIT_GUARD()
 
   if (reader.useMulticast || reader.suppressUnicast == false) {
+    if (needsFragmentation(*next)) {
+      sendFragments(reader.useMulticast ? reader.remoteMulticastLocator
+                                        : reader.remoteLocator,
+                    reader.useMulticast ? ENTITYID_UNKNOWN
+                                        : reader.remoteReaderGuid.entityId,
+                    *next, nullptr, true);
+      return true;
+    }
+    if (aggregateData(reader.useMulticast ? reader.remoteMulticastLocator
+                                          : reader.remoteLocator,
+                      *next,
+                      reader.useMulticast ? ENTITYID_UNKNOWN
+                                          : reader.remoteReaderGuid.entityId)) {
+      return true;
+    }
+
     PacketInfo info;
+    info.buffer.setPool(getTransmitPool());
     info.srcPort = m_srcPort;
 
     MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
@@ -404,9 +969,8 @@ bool StatefulWriterT<NetworkDriver>::sendDataWRMulticast(
       reid = reader.remoteReaderGuid.entityId;
     }
 
-    MessageFactory::addSubMessageData(info.buffer, next->data, next->inLineQoS,
-                                      next->sequenceNumber,
-                                      m_attributes.endpointGuid.entityId, reid);
+    MessageFactory::addSubMessageData(
+        info.buffer, *next, m_attributes.endpointGuid.entityId, reid);
 
     m_transport->sendPacket(info);
   }
@@ -491,6 +1055,7 @@ void StatefulWriterT<NetworkDriver>::sendHeartBeat() {
   for (auto &proxy : m_proxies) {
 
     PacketInfo info;
+    info.buffer.setPool(getTransmitPool());
     info.srcPort = m_srcPort;
 
     SequenceNumber_t firstSN;
@@ -537,6 +1102,11 @@ void StatefulWriterT<NetworkDriver>::sendHeartBeat() {
 
     info.destAddr = proxy.remoteLocator.getIp4Address();
     info.destPort = proxy.remoteLocator.port;
+    // The heartbeat announces the DATA still held back by the aggregator
+    flushAggregatedData(proxy.remoteLocator);
+    if (proxy.useMulticast) {
+      flushAggregatedData(proxy.remoteMulticastLocator);
+    }
     m_transport->sendPacket(info);
   }
   m_hbCount.value++;
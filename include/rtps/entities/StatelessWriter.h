@@ -30,6 +30,7 @@ public:
   const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
                                DataSize_t size, bool inLineQoS = false,
                                bool markDisposedAfterWrite = false) override;
+  using Writer::newChange;
   bool removeFromHistory(const SequenceNumber_t &s);
 
   void setAllChangesToUnsent() override;
@@ -37,10 +38,20 @@ public:
                     const GuidPrefix_t &sourceGuidPrefix) override;
   void reset() override;
 
+protected:
+  const CacheChange *addChangeToHistory(ChangeKind_t kind,
+                                        CacheChange &&change, bool inLineQoS,
+                                        bool markDisposedAfterWrite) override;
+  void sendPacket(PacketInfo &packet) override;
+
 private:
   NetworkDriver *m_transport;
 
   SimpleHistoryCache<Config::HISTORY_SIZE_STATELESS> m_history;
+
+  //! Sends the change at m_nextSequenceNumberToSend to all readers. Returns
+  //! false if there is none or the flow controllers defer it.
+  bool sendNextChange();
 };
 
 using StatelessWriter = StatelessWriterT<UdpDriver>;
@@ -16,6 +16,7 @@
 #include "rtps/communication/UdpDriver.h"
 #include "rtps/messages/MessageFactory.h"
 #include "rtps/storages/PBufWrapper.h"
+#include "rtps/utils/Diagnostics.h"
 #include "rtps/utils/Log.h"
 #include "rtps/utils/udpUtils.h"
 
@@ -71,6 +72,7 @@ bool StatelessWriterT<NetworkDriver>::init(TopicData attributes,
   m_is_initialized_ = true;
 
   m_proxies.clear();
+  m_multicastGroups.clear();
   m_history.clear();
 
   m_transport = &driver;
@@ -91,11 +93,42 @@ const CacheChange *StatelessWriterT<NetworkDriver>::newChange(
   if (isIrrelevant(kind)) {
     return nullptr;
   }
+
+  CacheChange change;
+  if (!change.setPayload(data, size)) {
+    SLW_LOG("Failed to allocate payload of %u bytes.\r\n", (unsigned)size);
+    return nullptr;
+  }
+  return addChangeToHistory(kind, std::move(change), inLineQoS,
+                            markDisposedAfterWrite);
+}
+
+template <typename NetworkDriver>
+const CacheChange *StatelessWriterT<NetworkDriver>::addChangeToHistory(
+    rtps::ChangeKind_t kind, CacheChange &&change, bool /*inLineQoS*/,
+    bool /*markDisposedAfterWrite*/) {
+  INIT_GUARD();
+  if (isIrrelevant(kind)) {
+    return nullptr;
+  }
+
+  compressPayload(change);
+
   Lock lock(m_mutex);
   if (!m_is_initialized_) {
     return nullptr;
   }
 
+  if (m_conflate && kind == ChangeKind_t::ALIVE) {
+    // Overwrite the newest change while it is still waiting to be sent
+    const SequenceNumber_t lastSN = m_history.getSeqNumMax();
+    if (!(lastSN < m_nextSequenceNumberToSend) &&
+        m_history.getChangeBySN(lastSN) != nullptr) {
+      Diagnostics::StatelessWriter::slw_conflated_samples++;
+      return m_history.replaceChange(lastSN, std::move(change), false);
+    }
+  }
+
   if (m_history.isFull()) {
     SequenceNumber_t newMin = ++SequenceNumber_t(m_history.getSeqNumMin());
     if (m_nextSequenceNumberToSend < newMin) {
@@ -105,8 +138,8 @@ const CacheChange *StatelessWriterT<NetworkDriver>::newChange(
     SLW_LOG("History is full, dropping oldest %s\r\n", this->m_attributes.topicName);
   }
 
-  auto *result = m_history.addChange(data, size);
-  if (mp_threadPool != nullptr) {
+  auto *result = m_history.addChange(std::move(change), false, false);
+  if (mp_threadPool != nullptr && !m_batchInsert) {
     mp_threadPool->addWorkload(this);
   }
 
@@ -140,74 +173,129 @@ void StatelessWriterT<NetworkDriver>::onNewAckNack(
   // Too lazy to respond
 }
 
+template <typename NetworkDriver>
+void StatelessWriterT<NetworkDriver>::sendPacket(PacketInfo &packet) {
+  m_transport->sendPacket(packet);
+}
+
 template <typename NetworkDriver>
 void StatelessWriterT<NetworkDriver>::progress() {
   INIT_GUARD();
-  // TODO smarter packaging e.g. by creating MessageStruct and serialize after
-  // adjusting values Reusing the pbuf is not possible. See
-  // https://www.nongnu.org/lwip/2_1_x/raw_api.html (Zero-Copy MACs)
-
   if (m_proxies.getNumElements() == 0) {
     SLW_LOG("No Proxy!\n");
   }
 
-  for (const auto &proxy : m_proxies) {
-
-    SLW_LOG("Progess.\n");
-    // Do nothing, if someone else sends for me... (Multicast)
-    if (proxy.useMulticast || !proxy.suppressUnicast || m_enforceUnicast) {
-      PacketInfo info;
-      info.srcPort = m_srcPort;
+  // Drains everything that is pending, a batch is scheduled only once
+  while (sendNextChange()) {
+  }
+}
 
-      MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
-      MessageFactory::addSubMessageTimeStamp(info.buffer);
+template <typename NetworkDriver>
+bool StatelessWriterT<NetworkDriver>::sendNextChange() {
+  // TODO smarter packaging e.g. by creating MessageStruct and serialize after
+  // adjusting values Reusing the pbuf is not possible. See
+  // https://www.nongnu.org/lwip/2_1_x/raw_api.html (Zero-Copy MACs)
 
-      {
-        Lock lock(m_mutex);
-        const CacheChange *next =
-            m_history.getChangeBySN(m_nextSequenceNumberToSend);
-        if (next == nullptr) {
-          SLW_LOG("Couldn't get a new CacheChange with SN "
-                  "(%i,%i)\n",
-                  m_nextSequenceNumberToSend.high,
-                  m_nextSequenceNumberToSend.low);
-          return;
-        } else {
-          SLW_LOG("Sending change with SN (%i,%i)\n",
-                  m_nextSequenceNumberToSend.high,
-                  m_nextSequenceNumberToSend.low);
+  {
+    uint32_t pendingPackets = 0;
+    DataSize_t payloadSize = 0;
+    {
+      Lock lock(m_mutex);
+      const CacheChange *pending =
+          m_history.getChangeBySN(m_nextSequenceNumberToSend);
+      if (pending == nullptr) {
+        SLW_LOG("Couldn't get a new CacheChange with SN "
+                "(%i,%i)\n",
+                m_nextSequenceNumberToSend.high,
+                m_nextSequenceNumberToSend.low);
+        return false;
+      }
+      payloadSize = pending->getDataSize();
+      for (const auto &proxy : m_proxies) {
+        if (proxy.localReader == nullptr &&
+            (proxy.useMulticast || !proxy.suppressUnicast ||
+             m_enforceUnicast)) {
+          ++pendingPackets;
         }
+      }
+    }
+    if (pendingPackets != 0 &&
+        !paceTransmission(pendingPackets * getDataPacketSize(payloadSize),
+                          pendingPackets)) {
+      // Resumed by the writer thread once the budget allows it
+      return false;
+    }
+  }
 
-        // Set EntityId to UNKNOWN if using multicast, because there might be
-        // different ones...
-        // TODO: mybe enhance by using UNKNOWN only if ids are really different
-        EntityId_t reid;
-        if (proxy.useMulticast && !m_enforceUnicast && proxy.unknown_eid) {
-          reid = ENTITYID_UNKNOWN;
-        } else {
-          reid = proxy.remoteReaderGuid.entityId;
-        }
-        MessageFactory::addSubMessageData(info.buffer, next->data, false,
-                                          next->sequenceNumber,
-                                          m_attributes.endpointGuid.entityId,
-                                          reid); // TODO
+  // Under one lock from the first reader until the sample is removed, so
+  // conflation cannot replace it in between. Local readers run their
+  // callbacks, they get the sample after unlocking.
+  LocalDelivery localDelivery;
+  {
+    Lock lock(m_mutex);
+    const CacheChange *next =
+        m_history.getChangeBySN(m_nextSequenceNumberToSend);
+    if (next == nullptr) {
+      SLW_LOG("Couldn't get a new CacheChange with SN "
+              "(%i,%i)\n",
+              m_nextSequenceNumberToSend.high, m_nextSequenceNumberToSend.low);
+      return false;
+    }
+    SLW_LOG("Sending change with SN (%i,%i)\n",
+            m_nextSequenceNumberToSend.high, m_nextSequenceNumberToSend.low);
+
+    for (const auto &proxy : m_proxies) {
+      if (proxy.localReader != nullptr) {
+        addLocalDelivery(localDelivery, proxy, *next);
+        continue;
       }
 
-      // Just usable for IPv4
-      // Decide which locator to be used unicast/multicast
+      // Do nothing, if someone else sends for me... (Multicast)
+      if (!proxy.useMulticast && proxy.suppressUnicast && !m_enforceUnicast) {
+        continue;
+      }
 
-      if (proxy.useMulticast && !m_enforceUnicast) {
-        info.destAddr = proxy.remoteMulticastLocator.getIp4Address();
-        info.destPort = (Ip4Port_t)proxy.remoteMulticastLocator.port;
+      // Set EntityId to UNKNOWN if using multicast, because there might be
+      // different ones...
+      // TODO: mybe enhance by using UNKNOWN only if ids are really different
+      EntityId_t reid;
+      if (proxy.useMulticast && !m_enforceUnicast && proxy.unknown_eid) {
+        reid = ENTITYID_UNKNOWN;
       } else {
-        info.destAddr = proxy.remoteLocator.getIp4Address();
-        info.destPort = (Ip4Port_t)proxy.remoteLocator.port;
+        reid = proxy.remoteReaderGuid.entityId;
+      }
+      // Just usable for IPv4
+      // Decide which locator to be used unicast/multicast
+      const LocatorIPv4 &destination =
+          proxy.useMulticast && !m_enforceUnicast
+              ? proxy.remoteMulticastLocator
+              : proxy.remoteLocator;
+      if (needsFragmentation(*next)) {
+        // Best effort, lost fragments drop the whole sample
+        sendFragments(destination, reid, *next, nullptr, false);
+        continue;
+      }
+      if (aggregateData(destination, *next, reid)) {
+        continue;
       }
-      
+
+      PacketInfo info;
+      info.buffer.setPool(getTransmitPool());
+      info.srcPort = m_srcPort;
+      MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
+      MessageFactory::addSubMessageTimeStamp(info.buffer);
+      MessageFactory::addSubMessageData(info.buffer, *next,
+                                        m_attributes.endpointGuid.entityId,
+                                        reid); // TODO
+      info.destAddr = destination.getIp4Address();
+      info.destPort = (Ip4Port_t)destination.port;
       m_transport->sendPacket(info);
     }
+
+    m_history.removeUntilIncl(m_nextSequenceNumberToSend);
+    ++m_nextSequenceNumberToSend;
   }
 
-  m_history.removeUntilIncl(m_nextSequenceNumberToSend);
-  ++m_nextSequenceNumberToSend;
+  deliverLocally(localDelivery);
+  return true;
 }
@@ -0,0 +1,101 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/entities/Domain.h"
+#include "rtps/messages/Encapsulation.h"
+#include "ucdr/microcdr.h"
+
+namespace rtps {
+
+/**
+ * Reader bound to a type at compile time, see TypedWriter for the traits.
+ * Samples are deserialized straight from the receive pbuf.
+ *
+ * A callback registered here gets this object as argument, so it must not
+ * be moved or destroyed while the callback is registered.
+ */
+template <class Traits> class TypedReader {
+public:
+  using Type = typename Traits::Type;
+  using callbackFunction_t = void (*)(void *arg, const Type &sample,
+                                      const ReaderCacheChange &cacheChange);
+
+  explicit TypedReader(Reader *reader = nullptr) : mp_reader(reader) {}
+  TypedReader(const TypedReader &other) = delete;
+  TypedReader &operator=(const TypedReader &other) = delete;
+
+  bool init(Domain &domain, Participant &part, bool reliable,
+            ip4_addr_t mcastaddress = {0},
+            const ReaderOptions &options = ReaderOptions{}) {
+    mp_reader = domain.createReader(part, Traits::TOPIC_NAME,
+                                    Traits::TYPE_NAME, reliable, mcastaddress,
+                                    options);
+    return mp_reader != nullptr;
+  }
+
+  bool isValid() const { return mp_reader != nullptr; }
+  Reader *getReader() const { return mp_reader; }
+
+  //! Only one callback per typed reader. Unregister via getReader().
+  Reader::callbackIdentifier_t
+  registerCallback(callbackFunction_t cb, void *arg,
+                   CallbackMode mode = CallbackMode::INLINE) {
+    if (mp_reader == nullptr || cb == nullptr || m_callback != nullptr) {
+      return 0;
+    }
+    m_callback = cb;
+    m_callbackArg = arg;
+    return mp_reader->registerCallback(callbackJumppad, this, mode);
+  }
+
+  //! Takes a sample of the sample queue of the reader, see ReaderOptions
+  bool take(Type &sample, uint32_t timeoutMs = 0) {
+    SampleHandle handle;
+    if (mp_reader == nullptr || !mp_reader->takeSample(handle, timeoutMs)) {
+      return false;
+    }
+    return handle.kind == ChangeKind_t::ALIVE &&
+           deserialize(handle.getData(), handle.getDataSize(), sample);
+  }
+
+  static bool deserialize(const uint8_t *data, DataSize_t size, Type &sample) {
+    ucdrEndianness endianness;
+    if (!Encapsulation::readHeader(data, size, endianness)) {
+      return false;
+    }
+    // Micro-CDR only reads, the cast does not modify the received data
+    ucdrBuffer buffer;
+    ucdr_init_buffer(&buffer,
+                     const_cast<uint8_t *>(data) + Encapsulation::HEADER_SIZE,
+                     size - Encapsulation::HEADER_SIZE);
+    buffer.endianness = endianness;
+    return Traits::deserialize(buffer, sample) &&
+           !ucdr_buffer_has_error(&buffer);
+  }
+
+private:
+  Reader *mp_reader;
+  callbackFunction_t m_callback = nullptr;
+  void *m_callbackArg = nullptr;
+
+  static void callbackJumppad(void *arg, const ReaderCacheChange &cacheChange) {
+    auto *self = static_cast<TypedReader *>(arg);
+    if (cacheChange.kind != ChangeKind_t::ALIVE) {
+      return;
+    }
+    Type sample{};
+    if (deserialize(cacheChange.getData(), cacheChange.getDataSize(), sample)) {
+      self->m_callback(self->m_callbackArg, sample, cacheChange);
+    }
+  }
+};
+
+} // namespace rtps
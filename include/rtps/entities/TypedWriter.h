@@ -0,0 +1,82 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/entities/Domain.h"
+#include "rtps/messages/Encapsulation.h"
+#include "ucdr/microcdr.h"
+
+namespace rtps {
+
+/**
+ * Writer bound to a type at compile time. Traits describe the topic:
+ *
+ *   struct PoseTraits {
+ *     using Type = Pose;
+ *     static constexpr const char *TOPIC_NAME = "pose";
+ *     static constexpr const char *TYPE_NAME = "geometry_msgs::msg::Pose";
+ *     static constexpr DataSize_t MAX_SERIALIZED_SIZE = 56;
+ *     static bool serialize(ucdrBuffer &buffer, const Pose &sample);
+ *     static bool deserialize(ucdrBuffer &buffer, Pose &sample);
+ *   };
+ *
+ * Samples are serialized right into a loaned transmit buffer of
+ * MAX_SERIALIZED_SIZE bytes plus the encapsulation header, there is no
+ * intermediate copy. Traits may derive from others to publish the same type
+ * on another topic. Numeric arrays are best (de)serialized with
+ * ArrayKernels::serializeArray and deserializeArray, SequenceTraits does so
+ * for topics made of a single numeric sequence.
+ */
+template <class Traits> class TypedWriter {
+public:
+  using Type = typename Traits::Type;
+
+  explicit TypedWriter(Writer *writer = nullptr) : mp_writer(writer) {}
+
+  bool init(Domain &domain, Participant &part, bool reliable,
+            bool enforceUnicast = false,
+            const WriterOptions &options = WriterOptions{}) {
+    mp_writer = domain.createWriter(part, Traits::TOPIC_NAME,
+                                    Traits::TYPE_NAME, reliable,
+                                    enforceUnicast, options);
+    return mp_writer != nullptr;
+  }
+
+  bool isValid() const { return mp_writer != nullptr; }
+  Writer *getWriter() const { return mp_writer; }
+
+  const CacheChange *write(const Type &sample) {
+    if (mp_writer == nullptr) {
+      return nullptr;
+    }
+    LoanedSample loan = mp_writer->loanSample(Encapsulation::HEADER_SIZE +
+                                              Traits::MAX_SERIALIZED_SIZE);
+    if (!loan.isValid()) {
+      return nullptr;
+    }
+
+    // Alignment of CDR is relative to the end of the encapsulation header
+    ucdrBuffer buffer;
+    ucdr_init_buffer(&buffer, loan.data() + Encapsulation::HEADER_SIZE,
+                     loan.capacity() - Encapsulation::HEADER_SIZE);
+    Encapsulation::writeHeader(loan.data(), buffer.endianness);
+    if (!Traits::serialize(buffer, sample) || ucdr_buffer_has_error(&buffer)) {
+      return nullptr;
+    }
+    return mp_writer->commitLoan(
+        std::move(loan),
+        Encapsulation::HEADER_SIZE + ucdr_buffer_length(&buffer));
+  }
+
+private:
+  Writer *mp_writer;
+};
+
+} // namespace rtps
@@ -0,0 +1,56 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/sys.h"
+#include "rtps/config.h"
+#include "rtps/utils/Lock.h"
+
+#include <array>
+
+namespace rtps {
+
+class Reader;
+
+/**
+ * Blocks an application thread on several readers at once. All attached
+ * readers signal the same semaphore when a sample is queued, so a single
+ * wait covers all of them. Only readers with a sample queue (see
+ * ReaderOptions) ever become ready, and a reader can be attached to one
+ * WaitSet at a time. Readers have to be detached before the WaitSet is
+ * destroyed.
+ */
+class WaitSet {
+public:
+  WaitSet() = default;
+  ~WaitSet();
+  WaitSet(const WaitSet &other) = delete;
+  WaitSet &operator=(const WaitSet &other) = delete;
+
+  bool attach(Reader &reader);
+  bool detach(Reader &reader);
+
+  /**
+   * Waits up to timeoutMs until at least one attached reader has samples,
+   * 0 only checks. Up to maxReady of them are written to ready. Returns
+   * the number of ready readers, which might exceed maxReady.
+   */
+  uint8_t wait(Reader **ready, uint8_t maxReady, uint32_t timeoutMs);
+
+private:
+  SemaphoreHandle_t m_mutex = nullptr;
+  sys_sem_t m_signal{};
+  std::array<Reader *, Config::WAITSET_MAX_READERS> m_readers{};
+
+  bool init();
+  uint8_t collectReady(Reader **ready, uint8_t maxReady);
+};
+
+} // namespace rtps
@@ -10,12 +10,18 @@
 #pragma once
 
 #include "rtps/ThreadPool.h"
+#include "rtps/communication/FlowController.h"
+#include "rtps/communication/TransmitAggregator.h"
 #include "rtps/discovery/TopicData.h"
+#include "rtps/entities/MulticastGroupIndex.h"
 #include "rtps/entities/ReaderProxy.h"
 #include "rtps/storages/CacheChange.h"
+#include "rtps/storages/LoanedSample.h"
 #include "rtps/storages/MemoryPool.h"
 #include "rtps/storages/PBufWrapper.h"
 
+#include <array>
+
 #ifdef DEBUG_BUILD
 #define COMPILE_INIT_GUARD
 #endif
@@ -33,6 +39,67 @@
 
 namespace rtps {
 
+//! Element of a batch passed to Writer::newChanges
+struct Sample {
+  const uint8_t *data = nullptr;
+  DataSize_t size = 0;
+  ChangeKind_t kind = ChangeKind_t::ALIVE;
+};
+
+//! Optional per-writer settings passed to Domain::createWriter
+struct WriterOptions {
+  FlowControlSettings flowControl;
+  //! Readers sharing a multicast locator needed to send to the group instead
+  //! of each reader, 0 disables multicast
+  uint8_t multicastMinReaders = Config::WRITER_MULTICAST_MIN_READERS;
+  //! Keeps only the newest unsent sample, e.g. for state-like topics
+  bool conflate = false;
+  //! CDR payloads of at least this many bytes are LZ4 compressed if that
+  //! makes them smaller, 0 disables compression
+  DataSize_t compressionThreshold = 0;
+  //! Reliable writers send the difference to the previous sample, with a
+  //! full key frame every this many samples. 0 disables delta encoding,
+  //! which is also off while conflating. A reader matched later cannot
+  //! decode the deltas in the history before the latest key frame, up to
+  //! this many samples of the history are skipped for it.
+  uint16_t deltaKeyFrameInterval = 0;
+};
+
+/**
+ * A sample for readers of the same Domain. Collected under the writer lock
+ * and delivered after releasing it, as the readers run their inline
+ * callbacks and must not block acknacks or repairs of the writer. Holds a
+ * reference to the payload, so the history may drop it in the meantime.
+ * The reference is released as well if it is never delivered.
+ */
+struct LocalDelivery {
+  LocalDelivery() = default;
+  LocalDelivery(const LocalDelivery &) = delete;
+  LocalDelivery &operator=(const LocalDelivery &) = delete;
+  ~LocalDelivery() {
+    if (buffer != nullptr) {
+      pbuf_free(buffer);
+    }
+  }
+
+  ChangeKind_t kind = ChangeKind_t::INVALID;
+  SequenceNumber_t sequenceNumber = {0, 0};
+  pbuf *buffer = nullptr;
+  DataSize_t size = 0;
+  std::array<Reader *, Config::NUM_READER_PROXIES_PER_WRITER> readers{};
+  std::array<Guid_t, Config::NUM_READER_PROXIES_PER_WRITER> readerGuids{};
+  uint8_t numReaders = 0;
+};
+
+//! Per-writer figures to judge whether compression pays off for a topic
+struct CompressionStats {
+  uint32_t compressedSamples = 0;
+  //! Large enough, but compressing did not make them smaller
+  uint32_t incompressibleSamples = 0;
+  uint32_t bytesSaved = 0;
+  uint32_t timeUs = 0;
+};
+
 class Writer {
 public:
   TopicData m_attributes;
@@ -43,6 +110,19 @@ public:
   virtual const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
                                        DataSize_t size);
 
+  //! Adds all samples under a single lock and schedules the writer once.
+  //! Returns the number of samples added. Batches larger than the history
+  //! overwrite their own oldest samples before they are sent.
+  uint32_t newChanges(const Sample *samples, uint32_t numSamples);
+
+  //! Borrows a contiguous buffer of size bytes to serialize a sample into.
+  //! Check isValid() on the result, allocation might fail.
+  LoanedSample loanSample(DataSize_t size);
+  //! Adds the first size bytes of a loaned buffer to the history without
+  //! copying them. The sample is consumed in any case.
+  const CacheChange *commitLoan(LoanedSample &&sample, DataSize_t size,
+                                ChangeKind_t kind = ChangeKind_t::ALIVE);
+
   //! Executes required steps like sending packets. Intended to be called by
   //! worker threads
   virtual void progress() = 0;
@@ -51,6 +131,15 @@ public:
   virtual void setAllChangesToUnsent() = 0;
   virtual void onNewAckNack(const SubmessageAckNack &msg,
                             const GuidPrefix_t &sourceGuidPrefix) = 0;
+  //! Resends the requested fragments of a sample, only reliable writers do
+  virtual void onNewNackFrag(const SubmessageNackFrag &msg,
+                             const GuidPrefix_t &sourceGuidPrefix);
+  //! Answers requests whose NACK response delay passed. Sets waitTicks to
+  //! the time until the next one is due or 0 if there is none.
+  virtual void sendDueRepairs(TickType_t now, TickType_t &waitTicks);
+  //! Schedules the writer again once the flow controllers allow sending.
+  //! Sets waitTicks to the time until then or 0 if it is not paced.
+  void resumePaced(TickType_t now, TickType_t &waitTicks);
 
   using dumpProxyCallback = void (*)(const Writer *writer, const ReaderProxy &,
                                      void *arg);
@@ -65,9 +154,26 @@ public:
 
   bool isBuiltinEndpoint();
 
+  //! Limits the user traffic of this writer. The participant controller is
+  //! shared by all user writers of a participant and may be a nullptr.
+  bool setFlowControl(const FlowControlSettings &settings,
+                      FlowController *participantController);
+  void setMulticastMinReaders(uint8_t minReaders);
+  //! If enabled, a new sample replaces the pending one as long as it has not
+  //! been sent. Disposals and unregistrations are never replaced.
+  void setConflation(bool enable);
+  //! See WriterOptions::compressionThreshold
+  void setCompression(DataSize_t threshold);
+  CompressionStats getCompressionStats();
+  //! User DATA is merged with that of other writers if set
+  void setTransmitAggregator(TransmitAggregator *aggregator);
+
 protected:
   SequenceNumber_t m_sedp_sequence_number;
 
+  //! Slab for outgoing messages, depending on the kind of traffic
+  PBufPool getTransmitPool();
+
   SemaphoreHandle_t m_mutex = nullptr;
   ThreadPool *mp_threadPool = nullptr;
 
@@ -75,22 +181,82 @@ protected:
 
   bool m_enforceUnicast;
 
+  FlowController m_flowController;
+  FlowController *mp_participantFlowController = nullptr;
+  TransmitAggregator *mp_transmitAggregator = nullptr;
+  //! Set while the writer waits for the budget, guarded by m_mutex
+  bool m_isPaced = false;
+  bool m_pacingReserved = false;
+  TickType_t m_pacedSince = 0;
+  TickType_t m_pacingTicks = 0;
+
   TopicKind_t m_topicKind = TopicKind_t::NO_KEY;
+  //! Set by newChanges, the writer is scheduled once after the batch
+  bool m_batchInsert = false;
+  bool m_conflate = false;
+  DataSize_t m_compressionThreshold = 0;
+  CompressionStats m_compressionStats;
   SequenceNumber_t m_nextSequenceNumberToSend;
 
   friend class SEDPAgent;
   virtual const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
                                        DataSize_t size, bool inLineQoS,
                                        bool markDisposedAfterWrite) = 0;
+  //! Same as newChange but takes over the payload of change
+  virtual const CacheChange *
+  addChangeToHistory(ChangeKind_t kind, CacheChange &&change, bool inLineQoS,
+                     bool markDisposedAfterWrite) = 0;
 
   friend class SizeInspector;
   bool m_is_initialized_ = false;
   virtual ~Writer() = default;
   MemoryPool<ReaderProxy, Config::NUM_READER_PROXIES_PER_WRITER> m_proxies;
+  MulticastGroupIndex<Config::NUM_READER_PROXIES_PER_WRITER> m_multicastGroups;
 
-  void resetSendOptions();
-  void manageSendOptions();
+  void removeFromMulticastGroups(bool (*jumppad)(void *, const ReaderProxy &),
+                                 void *isElementToRemove);
   bool isIrrelevant(ChangeKind_t kind) const;
+  //! Replaces the payload by its compressed form if enabled and worth it.
+  //! Must be called without the writer lock, compressing takes a while.
+  void compressPayload(CacheChange &change);
+
+  //! Accounts the transmission against the flow controllers. Returns false
+  //! if a deferrable transmission has to wait for the budget. The writer
+  //! thread is shared, so the writer is resumed by resumePaced() instead of
+  //! blocking it. The budget stays reserved for the next call.
+  bool paceTransmission(uint32_t bytes, uint32_t packets,
+                        bool deferrable = true);
+  static uint32_t getDataPacketSize(DataSize_t payloadSize);
+  //! Hands a DATA submessage to the transmit aggregator. Returns false if the
+  //! caller has to send it on its own.
+  bool aggregateData(const LocatorIPv4 &destination, const CacheChange &change,
+                     const EntityId_t &readerId);
+  //! Sends the DATA still held back for destination. Called before anything
+  //! that goes straight to the transport, e.g. HEARTBEAT or repairs, so the
+  //! reader never sees those before the DATA they refer to.
+  void flushAggregatedData(const LocatorIPv4 &destination);
+
+  //! Adds the reader of proxy to delivery, which takes a reference to the
+  //! payload of change on first use. Needs the mutex.
+  void addLocalDelivery(LocalDelivery &delivery, const ReaderProxy &proxy,
+                        const CacheChange &change);
+  //! Hands the sample to the readers, bypassing the network, and releases
+  //! the payload. Runs their inline callbacks on the calling thread, so the
+  //! mutex must not be held.
+  void deliverLocally(LocalDelivery &delivery);
+
+  //! Payloads above Config::DATA_FRAG_SIZE are sent as DATA_FRAG
+  static bool needsFragmentation(const CacheChange &change);
+  //! Sends the fragments of change in as few messages as possible, all of
+  //! them if requested is a nullptr. A HEARTBEAT_FRAG is appended if
+  //! announce is set. Returns the number of bytes sent.
+  uint32_t sendFragments(const LocatorIPv4 &destination,
+                         const EntityId_t &readerId, const CacheChange &change,
+                         const FragmentNumberSet *requested, bool announce);
+  virtual void sendPacket(PacketInfo &packet) = 0;
+
+private:
+  Count_t m_hbFragCount{0};
 };
 
 }
@@ -9,7 +9,11 @@
 
 #pragma once
 
+#include "FreeRTOS.h"
 #include "rtps/common/types.h"
+#include "rtps/config.h"
+#include "rtps/storages/ReorderBuffer.h"
+#include <algorithm>
 #include <rtps/common/Locator.h>
 
 namespace rtps {
@@ -28,28 +32,124 @@ struct WriterProxy {
         expectedSN(SequenceNumber_t{0, 1}), ackNackCount{1}, hbCount{0},
         is_reliable(reliable), remoteLocator(loc) {}
 
-  // For now, we don't store any packets, so we just request all starting from
-  // the next expected
-  SequenceNumberSet getMissing(const SequenceNumber_t &firstAvail,
-                               const SequenceNumber_t &lastAvail) {
+  //! Bit i is set if expectedSN + i has been received already. Same layout
+  //! as the bitmap of a SequenceNumberSet.
+  std::array<uint32_t, SNS_MAX_NUM_BITS / 32> receivedBitMap{};
+
+  //! Samples received ahead of expectedSN, owned by the stateful reader
+  ReorderBuffer<Config::SFR_REORDER_BUFFER_SIZE> reorderBuffer;
+
+  //! Last plain sample of a delta encoding writer, owned by the reader
+  pbuf *deltaBase = nullptr;
+  SequenceNumber_t deltaBaseSN;
+
+  //! Deferred ACKNACK, requesting everything missing up to ackNackLastSN
+  bool ackNackPending = false;
+  TickType_t ackNackScheduled = 0;
+  SequenceNumber_t ackNackLastSN;
+
+  Count_t nackFragCount{0};
+
+  bool isReceived(const SequenceNumber_t &sn) const {
+    if (sn < expectedSN) {
+      return true;
+    }
+    const uint64_t bit = sn - expectedSN;
+    if (bit >= SNS_MAX_NUM_BITS) {
+      return false;
+    }
+    return (receivedBitMap[bit / 32] & (uint32_t{1} << (31 - (bit % 32)))) !=
+           0;
+  }
+
+  //! Returns false if the sequence number is outside of the tracked window
+  bool markReceived(const SequenceNumber_t &sn) {
+    if (sn < expectedSN) {
+      return true;
+    }
+    const uint64_t bit = sn - expectedSN;
+    if (bit >= SNS_MAX_NUM_BITS) {
+      return false;
+    }
+    receivedBitMap[bit / 32] |= uint32_t{1} << (31 - (bit % 32));
+    return true;
+  }
+
+  //! Moves expectedSN forward and shifts the received set accordingly
+  void advanceExpectedSN(const SequenceNumber_t &newExpectedSN) {
+    if (newExpectedSN <= expectedSN) {
+      return;
+    }
+    const uint64_t delta = newExpectedSN - expectedSN;
+    expectedSN = newExpectedSN;
+    if (delta >= SNS_MAX_NUM_BITS) {
+      receivedBitMap.fill(0);
+      return;
+    }
+
+    const auto wordShift = static_cast<uint32_t>(delta / 32);
+    const auto bitShift = static_cast<uint32_t>(delta % 32);
+    const uint32_t numWords = receivedBitMap.size();
+    for (uint32_t i = 0; i < numWords; ++i) {
+      const uint32_t src = i + wordShift;
+      const uint32_t upper = src < numWords ? receivedBitMap[src] : 0;
+      const uint32_t lower = src + 1 < numWords ? receivedBitMap[src + 1] : 0;
+      receivedBitMap[i] =
+          bitShift == 0 ? upper
+                        : (upper << bitShift) | (lower >> (32 - bitShift));
+    }
+  }
+
+  //! Skips all sequence numbers that have already been received
+  void advanceToFirstMissing() {
+    uint32_t bit = 0;
+    while (bit < SNS_MAX_NUM_BITS &&
+           (receivedBitMap[bit / 32] & (uint32_t{1} << (31 - (bit % 32))))) {
+      ++bit;
+    }
+    advanceExpectedSN(expectedSN + bit);
+  }
+
+  /**
+   * Requests every sequence number in [expectedSN; lastAvail] that has not
+   * been received yet. The set covers up to SNS_MAX_NUM_BITS sequence numbers
+   * and numBits ends at the last missing one.
+   */
+  SequenceNumberSet getMissing(const SequenceNumber_t & /*firstAvail*/,
+                               const SequenceNumber_t &lastAvail) const {
     SequenceNumberSet set;
+    set.base = expectedSN;
+    set.numBits = 0;
     if (lastAvail < expectedSN) {
-      set.base = expectedSN;
-      set.numBits = 0;
-    } else {
-      set.base = expectedSN;
-      SequenceNumber_t i;
-      uint32_t bit;
-      for (bit = 0, i = expectedSN; i <= lastAvail && bit < SNS_MAX_NUM_BITS;
-           i++, bit++) {
-        set.bitMap[0] |= uint32_t{1} << (31 - bit);
-        set.numBits++;
+      return set;
+    }
+
+    const uint64_t available = (lastAvail - expectedSN) + 1;
+    const auto numCandidates = static_cast<uint32_t>(
+        available < SNS_MAX_NUM_BITS ? available : SNS_MAX_NUM_BITS);
+    for (uint32_t word = 0; word * 32 < numCandidates; ++word) {
+      const uint32_t bitsInWord =
+          std::min<uint32_t>(32, numCandidates - word * 32);
+      const uint32_t mask =
+          bitsInWord == 32 ? UINT32_MAX : ~(UINT32_MAX >> bitsInWord);
+      set.bitMap[word] = ~receivedBitMap[word] & mask;
+      if (set.bitMap[word] != 0) {
+        set.numBits = word * 32 + 32 - __builtin_ctz(set.bitMap[word]);
       }
     }
 
     return set;
   }
 
+  //! Has to be called before the proxy is dropped
+  void releaseSamples() {
+    reorderBuffer.clear();
+    if (deltaBase != nullptr) {
+      pbuf_free(deltaBase);
+      deltaBase = nullptr;
+    }
+  }
+
   Count_t getNextAckNackCount() {
     const Count_t tmp = ackNackCount;
     ++ackNackCount.value;
@@ -0,0 +1,72 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/common/types.h"
+#include "rtps/messages/MessageTypes.h"
+#include "ucdr/microcdr.h"
+
+namespace rtps {
+namespace Encapsulation {
+
+//! Scheme identifier followed by two bytes of options
+constexpr DataSize_t HEADER_SIZE = 4;
+//! Set in the first options byte if the body is LZ4 compressed. The
+//! uncompressed body size follows the header as 32 bit little endian.
+constexpr uint8_t OPTION_COMPRESSED = 0x80;
+constexpr DataSize_t COMPRESSED_HEADER_SIZE = HEADER_SIZE + 4;
+//! Set in the first options byte if the body is delta encoded. The header
+//! is followed by the plain body size as 32 bit little endian and the
+//! sequence number of the base sample as two 32 bit little endian words,
+//! high first. Key frames carry sequence number 0 and the plain body.
+constexpr uint8_t OPTION_DELTA = 0x40;
+constexpr DataSize_t DELTA_HEADER_SIZE = HEADER_SIZE + 12;
+
+inline void writeHeader(uint8_t *data, ucdrEndianness endianness) {
+  const std::array<uint8_t, 2> &scheme = endianness == UCDR_LITTLE_ENDIANNESS
+                                              ? SMElement::SCHEME_CDR_LE
+                                              : SMElement::SCHEME_CDR_BE;
+  data[0] = scheme[0];
+  data[1] = scheme[1];
+  data[2] = 0;
+  data[3] = 0;
+}
+
+//! Returns false if the payload is not plain CDR
+inline bool readHeader(const uint8_t *data, DataSize_t size,
+                       ucdrEndianness &endianness) {
+  if (data == nullptr || size < HEADER_SIZE || data[0] != 0x00) {
+    return false;
+  }
+  if (data[1] == SMElement::SCHEME_CDR_LE[1]) {
+    endianness = UCDR_LITTLE_ENDIANNESS;
+  } else if (data[1] == SMElement::SCHEME_CDR_BE[1]) {
+    endianness = UCDR_BIG_ENDIANNESS;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+inline bool isCompressed(const uint8_t *data, DataSize_t size) {
+  ucdrEndianness endianness;
+  return size >= COMPRESSED_HEADER_SIZE &&
+         readHeader(data, size, endianness) &&
+         (data[2] & OPTION_COMPRESSED) != 0;
+}
+
+inline bool isDelta(const uint8_t *data, DataSize_t size) {
+  ucdrEndianness endianness;
+  return size >= DELTA_HEADER_SIZE && readHeader(data, size, endianness) &&
+         (data[2] & OPTION_DELTA) != 0;
+}
+
+} // namespace Encapsulation
+} // namespace rtps
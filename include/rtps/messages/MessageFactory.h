@@ -15,6 +15,7 @@
 #include "rtps/common/types.h"
 #include "rtps/config.h"
 #include "rtps/messages/MessageTypes.h"
+#include "rtps/storages/CacheChange.h"
 #include "rtps/utils/sysFunctions.h"
 
 namespace rtps {
@@ -83,9 +84,11 @@ void addSubMessageTimeStamp(Buffer &buffer, bool setInvalid = false) {
 }
 
 template <class Buffer>
-void addSubMessageData(Buffer &buffer, const Buffer &filledPayload,
-                       bool containsInlineQos, const SequenceNumber_t &SN,
-                       const EntityId_t &writerID, const EntityId_t &readerID) {
+void addSubMessageDataHeader(Buffer &buffer, DataSize_t payloadSize,
+                             bool hasPayload, bool containsInlineQos,
+                             const SequenceNumber_t &SN,
+                             const EntityId_t &writerID,
+                             const EntityId_t &readerID) {
   SubmessageData msg;
   msg.header.submessageId = SubmessageKind::DATA;
 #if IS_LITTLE_ENDIAN
@@ -94,14 +97,13 @@ void addSubMessageData(Buffer &buffer, const Buffer &filledPayload,
   msg.header.flags = FLAG_BIG_ENDIAN;
 #endif
 
-  msg.header.octetsToNextHeader = SubmessageData::getRawSize() +
-                                  filledPayload.spaceUsed() -
-                                  numBytesUntilEndOfLength;
+  msg.header.octetsToNextHeader =
+      SubmessageData::getRawSize() + payloadSize - numBytesUntilEndOfLength;
 
   if (containsInlineQos) {
     msg.header.flags |= FLAG_INLINE_QOS;
   }
-  if (filledPayload.isValid()) {
+  if (hasPayload) {
     msg.header.flags |= FLAG_DATA_PAYLOAD;
   }
 
@@ -115,10 +117,146 @@ void addSubMessageData(Buffer &buffer, const Buffer &filledPayload,
   msg.octetsToInlineQos = octetsToInlineQoS;
 
   serializeMessage(buffer, msg);
+}
+
+template <class Buffer>
+void addSubMessageData(Buffer &buffer, const Buffer &filledPayload,
+                       bool containsInlineQos, const SequenceNumber_t &SN,
+                       const EntityId_t &writerID, const EntityId_t &readerID,
+                       bool copyPayload = false) {
+  addSubMessageDataHeader(buffer, filledPayload.spaceUsed(),
+                          filledPayload.isValid(), containsInlineQos, SN,
+                          writerID, readerID);
 
   if (filledPayload.isValid()) {
-    buffer.append(filledPayload);
+    if (copyPayload) {
+      buffer.appendCopy(filledPayload);
+    } else {
+      buffer.append(filledPayload);
+    }
+  }
+}
+
+//! Inline payloads are always copied, copyPayload only affects pbufs
+template <class Buffer>
+void addSubMessageData(Buffer &buffer, const CacheChange &change,
+                       const EntityId_t &writerID, const EntityId_t &readerID,
+                       bool copyPayload = false) {
+  if (!change.hasInlinePayload()) {
+    addSubMessageData(buffer, change.data, change.inLineQoS,
+                      change.sequenceNumber, writerID, readerID, copyPayload);
+    return;
+  }
+
+  addSubMessageDataHeader(buffer, change.inlineSize, true, change.inLineQoS,
+                          change.sequenceNumber, writerID, readerID);
+  if (buffer.reserve(change.inlineSize)) {
+    buffer.append(change.inlinePayload.data(), change.inlineSize);
+  }
+}
+
+//! Number of DATA_FRAG fragments a payload of size bytes is split into
+inline uint32_t getNumFragments(DataSize_t size) {
+  return (size + Config::DATA_FRAG_SIZE - 1) / Config::DATA_FRAG_SIZE;
+}
+
+//! Payload bytes carried by fragment fragmentNum (starting at 1)
+inline DataSize_t getFragmentSize(DataSize_t sampleSize,
+                                  uint32_t fragmentNum) {
+  const uint32_t offset = (fragmentNum - 1) * Config::DATA_FRAG_SIZE;
+  if (offset >= sampleSize) {
+    return 0;
+  }
+  const uint32_t remaining = sampleSize - offset;
+  return static_cast<DataSize_t>(remaining < Config::DATA_FRAG_SIZE
+                                     ? remaining
+                                     : Config::DATA_FRAG_SIZE);
+}
+
+//! Adds a DATA_FRAG holding a copy of fragment fragmentNum of change
+template <class Buffer>
+bool addSubMessageDataFrag(Buffer &buffer, const CacheChange &change,
+                           uint32_t fragmentNum, const EntityId_t &writerID,
+                           const EntityId_t &readerID) {
+  const DataSize_t sampleSize = change.getDataSize();
+  const DataSize_t size = getFragmentSize(sampleSize, fragmentNum);
+  if (size == 0 || change.hasInlinePayload()) {
+    return false;
+  }
+
+  SubmessageDataFrag msg;
+  msg.header.submessageId = SubmessageKind::DATA_FRAG;
+#if IS_LITTLE_ENDIAN
+  msg.header.flags = FLAG_LITTLE_ENDIAN;
+#else
+  msg.header.flags = FLAG_BIG_ENDIAN;
+#endif
+  // Inline QoS is part of the payload here, so the flag is never set
+  msg.header.octetsToNextHeader =
+      SubmessageDataFrag::getRawSize() + size - numBytesUntilEndOfLength;
+
+  msg.extraFlags = 0;
+  msg.octetsToInlineQos = SubmessageDataFrag::getRawSize() -
+                          SubmessageHeader::getRawSize() - 4;
+  msg.readerId = readerID;
+  msg.writerId = writerID;
+  msg.writerSN = change.sequenceNumber;
+  msg.fragmentStartingNum.value = fragmentNum;
+  msg.fragmentsInSubmessage = 1;
+  msg.fragmentSize = Config::DATA_FRAG_SIZE;
+  msg.sampleSize = sampleSize;
+
+  if (!serializeMessage(buffer, msg)) {
+    return false;
   }
+  return buffer.appendCopy(change.data,
+                           (fragmentNum - 1) * Config::DATA_FRAG_SIZE, size);
+}
+
+template <class Buffer>
+void addHeartbeatFrag(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
+                      const SequenceNumber_t &writerSN,
+                      FragmentNumber_t lastFragmentNum, Count_t count) {
+  SubmessageHeartbeatFrag subMsg;
+  subMsg.header.submessageId = SubmessageKind::HEARTBEAT_FRAG;
+  subMsg.header.octetsToNextHeader =
+      SubmessageHeartbeatFrag::getRawSize() - numBytesUntilEndOfLength;
+#if IS_LITTLE_ENDIAN
+  subMsg.header.flags = FLAG_LITTLE_ENDIAN;
+#else
+  subMsg.header.flags = FLAG_BIG_ENDIAN;
+#endif
+
+  subMsg.writerId = writerId;
+  subMsg.readerId = readerId;
+  subMsg.writerSN = writerSN;
+  subMsg.lastFragmentNum = lastFragmentNum;
+  subMsg.count = count;
+
+  serializeMessage(buffer, subMsg);
+}
+
+template <class Buffer>
+bool addNackFrag(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
+                 const SequenceNumber_t &writerSN,
+                 const FragmentNumberSet &missing, Count_t count) {
+  SubmessageNackFrag subMsg;
+  subMsg.header.submessageId = SubmessageKind::NACK_FRAG;
+#if IS_LITTLE_ENDIAN
+  subMsg.header.flags = FLAG_LITTLE_ENDIAN;
+#else
+  subMsg.header.flags = FLAG_BIG_ENDIAN;
+#endif
+  subMsg.header.octetsToNextHeader =
+      SubmessageNackFrag::getRawSize(missing) - numBytesUntilEndOfLength;
+
+  subMsg.writerId = writerId;
+  subMsg.readerId = readerId;
+  subMsg.writerSN = writerSN;
+  subMsg.fragmentNumberState = missing;
+  subMsg.count = count;
+
+  return serializeMessage(buffer, subMsg);
 }
 
 template <class Buffer>
@@ -174,9 +312,9 @@ void addAckNack(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
 }
 
 template <class Buffer>
-void addSubmessageGap(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
-                      const SequenceNumber_t &firstMissing,
-                      const SequenceNumber_t &nextValid) {
+bool addSubmessageGap(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
+                      const SequenceNumber_t &gapStart,
+                      const SequenceNumberSet &gapList) {
   SubmessageGap subMsg;
   subMsg.header.submessageId = SubmessageKind::GAP;
 #if IS_LITTLE_ENDIAN
@@ -184,15 +322,25 @@ void addSubmessageGap(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
 #else
   subMsg.header.flags = FLAG_BIG_ENDIAN;
 #endif
-  subMsg.header.octetsToNextHeader = 32;
+  subMsg.header.octetsToNextHeader =
+      SubmessageGap::getRawSize(gapList) - numBytesUntilEndOfLength;
 
   subMsg.writerId = writerId;
   subMsg.readerId = readerId;
-  subMsg.gapStart = firstMissing;
-  subMsg.gapList.base = nextValid;
-  subMsg.gapList.numBits = 0;
+  subMsg.gapStart = gapStart;
+  subMsg.gapList = gapList;
 
-  serializeMessage(buffer, subMsg);
+  return serializeMessage(buffer, subMsg);
+}
+
+template <class Buffer>
+bool addSubmessageGap(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
+                      const SequenceNumber_t &firstMissing,
+                      const SequenceNumber_t &nextValid) {
+  SequenceNumberSet gapList;
+  gapList.base = nextValid;
+  gapList.numBits = 0;
+  return addSubmessageGap(buffer, writerId, readerId, firstMissing, gapList);
 }
 
 }
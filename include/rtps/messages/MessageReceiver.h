@@ -15,6 +15,8 @@
 #include "rtps/config.h"
 #include "rtps/discovery/BuiltInEndpoints.h"
 
+struct pbuf;
+
 namespace rtps {
 class Reader;
 class Writer;
@@ -30,7 +32,8 @@ public:
 
   explicit MessageReceiver(Participant *part);
 
-  bool processMessage(const uint8_t *data, DataSize_t size);
+  bool processMessage(const uint8_t *data, DataSize_t size,
+                      pbuf *buffer = nullptr);
 
 private:
   Participant *mp_part;
@@ -53,6 +56,10 @@ private:
                              const SubmessageHeader &submsgHeader);
   bool processHeartbeatSubmessage(MessageProcessingInfo &msgInfo);
   bool processAckNackSubmessage(MessageProcessingInfo &msgInfo);
+  bool processDataFragSubmessage(MessageProcessingInfo &msgInfo,
+                                 const SubmessageHeader &submsgHeader);
+  bool processNackFragSubmessage(MessageProcessingInfo &msgInfo);
+  bool processHeartbeatFragSubmessage(MessageProcessingInfo &msgInfo);
 };
 
 }
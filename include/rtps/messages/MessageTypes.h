@@ -13,6 +13,8 @@
 
 #include "rtps/common/types.h"
 
+struct pbuf;
+
 namespace rtps {
 
 namespace SMElement {
@@ -93,6 +95,7 @@ enum BuildInEndpointSet : uint32_t {
 
 // TODO endianess
 
+const std::array<uint8_t, 2> SCHEME_CDR_BE{0x00, 0x00};
 const std::array<uint8_t, 2> SCHEME_CDR_LE{0x00, 0x01};
 const std::array<uint8_t, 2> SCHEME_PL_CDR_LE{0x00, 0x03};
 
@@ -207,6 +210,10 @@ struct SubmessageGap {
            (2 * (3 + 1) + 8 + 8 +
             4); // 2*EntityID +  GapStart + bitmapBase + numBits
   }
+
+  static uint16_t getRawSize(const SequenceNumberSet &set) {
+    return getRawSizeWithSingleElementSNSet() + 4 * set.getNumWords();
+  }
 };
 
 struct SubmessageAckNack {
@@ -216,10 +223,7 @@ struct SubmessageAckNack {
   SequenceNumberSet readerSNState;
   Count_t count;
   static uint16_t getRawSize(const SequenceNumberSet &set) {
-    uint16_t bitMapSize = 0;
-    if (set.numBits != 0) {
-      bitMapSize = SNS_NUM_BYTES;
-    }
+    const uint16_t bitMapSize = 4 * set.getNumWords();
     return getRawSizeWithoutSNSet() + sizeof(SequenceNumber_t) +
            sizeof(uint32_t) + bitMapSize; // SequenceNumberSet
   }
@@ -228,6 +232,57 @@ struct SubmessageAckNack {
   }
 };
 
+//! Carries fragments of a sample, followed by their payload
+struct SubmessageDataFrag {
+  SubmessageHeader header;
+  uint16_t extraFlags;
+  uint16_t octetsToInlineQos;
+  EntityId_t readerId;
+  EntityId_t writerId;
+  SequenceNumber_t writerSN;
+  FragmentNumber_t fragmentStartingNum;
+  uint16_t fragmentsInSubmessage;
+  uint16_t fragmentSize;
+  uint32_t sampleSize;
+  static constexpr uint16_t getRawSize() {
+    return SubmessageHeader::getRawSize() + sizeof(uint16_t) +
+           sizeof(uint16_t) + (2 * 3 + 2 * 1) // EntityID
+           + sizeof(SequenceNumber_t) + sizeof(FragmentNumber_t) +
+           2 * sizeof(uint16_t) + sizeof(uint32_t);
+  }
+};
+
+struct SubmessageNackFrag {
+  SubmessageHeader header;
+  EntityId_t readerId;
+  EntityId_t writerId;
+  SequenceNumber_t writerSN;
+  FragmentNumberSet fragmentNumberState;
+  Count_t count;
+  static uint16_t getRawSize(const FragmentNumberSet &set) {
+    return getRawSizeWithoutFNSet() + sizeof(FragmentNumber_t) +
+           sizeof(uint32_t) + 4 * set.getNumWords();
+  }
+  static uint16_t getRawSizeWithoutFNSet() {
+    return SubmessageHeader::getRawSize() + (2 * (3 + 1)) +
+           sizeof(SequenceNumber_t) + sizeof(Count_t);
+  }
+};
+
+struct SubmessageHeartbeatFrag {
+  SubmessageHeader header;
+  EntityId_t readerId;
+  EntityId_t writerId;
+  SequenceNumber_t writerSN;
+  FragmentNumber_t lastFragmentNum;
+  Count_t count;
+  static constexpr uint16_t getRawSize() {
+    return SubmessageHeader::getRawSize() + (2 * 3 + 2 * 1) // EntityID
+           + sizeof(SequenceNumber_t) + sizeof(FragmentNumber_t) +
+           sizeof(Count_t);
+  }
+};
+
 template <typename Buffer>
 bool serializeMessage(Buffer &buffer, Header &header) {
   if (!buffer.reserve(Header::getRawSize())) {
@@ -344,7 +399,7 @@ bool serializeMessage(Buffer &buffer, SubmessageAckNack &msg) {
                 sizeof(uint32_t));
   if (msg.readerSNState.numBits != 0) {
     buffer.append(reinterpret_cast<uint8_t *>(msg.readerSNState.bitMap.data()),
-                  4 * ((msg.readerSNState.numBits / 32) + 1));
+                  4 * msg.readerSNState.getNumWords());
   }
   buffer.append(reinterpret_cast<uint8_t *>(&msg.count.value),
                 sizeof(msg.count.value));
@@ -353,10 +408,10 @@ bool serializeMessage(Buffer &buffer, SubmessageAckNack &msg) {
 
 template <typename Buffer>
 bool serializeMessage(Buffer &buffer, SubmessageGap &msg) {
-  if (msg.gapList.numBits != 0) {
+  if (msg.gapList.numBits > SNS_MAX_NUM_BITS) {
     return false;
   }
-  if (!buffer.reserve(36)) {
+  if (!buffer.reserve(SubmessageGap::getRawSize(msg.gapList))) {
     return false;
   }
 
@@ -382,18 +437,117 @@ bool serializeMessage(Buffer &buffer, SubmessageGap &msg) {
   buffer.append(reinterpret_cast<uint8_t *>(&msg.gapList.numBits),
                 sizeof(uint32_t));
 
-  buffer.append(reinterpret_cast<uint8_t *>(&msg.gapList.numBits),
+  if (msg.gapList.numBits != 0) {
+    buffer.append(reinterpret_cast<uint8_t *>(msg.gapList.bitMap.data()),
+                  4 * msg.gapList.getNumWords());
+  }
+
+  return true;
+}
+
+template <typename Buffer>
+bool serializeMessage(Buffer &buffer, SubmessageDataFrag &msg) {
+  if (!buffer.reserve(SubmessageDataFrag::getRawSize())) {
+    return false;
+  }
+
+  serializeMessage(buffer, msg.header);
+
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.extraFlags), sizeof(uint16_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.octetsToInlineQos),
+                sizeof(uint16_t));
+  buffer.append(msg.readerId.entityKey.data(), msg.readerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.readerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(msg.writerId.entityKey.data(), msg.writerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.high),
+                sizeof(msg.writerSN.high));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.low),
+                sizeof(msg.writerSN.low));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.fragmentStartingNum.value),
+                sizeof(msg.fragmentStartingNum.value));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.fragmentsInSubmessage),
+                sizeof(uint16_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.fragmentSize),
+                sizeof(uint16_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.sampleSize),
                 sizeof(uint32_t));
+  return true;
+}
 
+template <typename Buffer>
+bool serializeMessage(Buffer &buffer, SubmessageNackFrag &msg) {
+  if (msg.fragmentNumberState.numBits > FNS_MAX_NUM_BITS) {
+    return false;
+  }
+  if (!buffer.reserve(
+          SubmessageNackFrag::getRawSize(msg.fragmentNumberState))) {
+    return false;
+  }
+
+  serializeMessage(buffer, msg.header);
+
+  buffer.append(msg.readerId.entityKey.data(), msg.readerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.readerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(msg.writerId.entityKey.data(), msg.writerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.high),
+                sizeof(msg.writerSN.high));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.low),
+                sizeof(msg.writerSN.low));
+  FragmentNumberSet &set = msg.fragmentNumberState;
+  buffer.append(reinterpret_cast<uint8_t *>(&set.base.value),
+                sizeof(set.base.value));
+  buffer.append(reinterpret_cast<uint8_t *>(&set.numBits), sizeof(uint32_t));
+  if (set.numBits != 0) {
+    buffer.append(reinterpret_cast<uint8_t *>(set.bitMap.data()),
+                  4 * set.getNumWords());
+  }
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.count.value),
+                sizeof(msg.count.value));
+  return true;
+}
+
+template <typename Buffer>
+bool serializeMessage(Buffer &buffer, SubmessageHeartbeatFrag &msg) {
+  if (!buffer.reserve(SubmessageHeartbeatFrag::getRawSize())) {
+    return false;
+  }
+
+  serializeMessage(buffer, msg.header);
+
+  buffer.append(msg.readerId.entityKey.data(), msg.readerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.readerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(msg.writerId.entityKey.data(), msg.writerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.high),
+                sizeof(msg.writerSN.high));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.low),
+                sizeof(msg.writerSN.low));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.lastFragmentNum.value),
+                sizeof(msg.lastFragmentNum.value));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.count.value),
+                sizeof(msg.count.value));
   return true;
 }
 
 struct MessageProcessingInfo {
-  MessageProcessingInfo(const uint8_t *data, DataSize_t size)
-      : data(data), size(size) {}
+  MessageProcessingInfo(const uint8_t *data, DataSize_t size,
+                        pbuf *buffer = nullptr)
+      : data(data), size(size), buffer(buffer) {}
   const uint8_t *data;
   const DataSize_t size;
 
+  //! Received pbuf holding data, if any. Allows to keep samples beyond the
+  //! processing of the message.
+  pbuf *const buffer;
+
   //! Offset to the next unprocessed byte
   DataSize_t nextPos = 0;
 
@@ -420,6 +574,15 @@ bool deserializeMessage(const MessageProcessingInfo &info,
 
 bool deserializeMessage(const MessageProcessingInfo &info, SubmessageGap &msg);
 
+bool deserializeMessage(const MessageProcessingInfo &info,
+                        SubmessageDataFrag &msg);
+
+bool deserializeMessage(const MessageProcessingInfo &info,
+                        SubmessageNackFrag &msg);
+
+bool deserializeMessage(const MessageProcessingInfo &info,
+                        SubmessageHeartbeatFrag &msg);
+
 void deserializeSNS(const uint8_t *&position, SequenceNumberSet &set,
                     size_t num_bitfields);
 
@@ -10,8 +10,12 @@
 #pragma once
 
 #include "rtps/common/types.h"
+#include "rtps/config.h"
 #include "rtps/storages/PBufWrapper.h"
 
+#include <array>
+#include <cstring>
+
 namespace rtps {
 struct CacheChange {
   ChangeKind_t kind = ChangeKind_t::INVALID;
@@ -20,6 +24,9 @@ struct CacheChange {
   TickType_t sentTickCount = 0;
   SequenceNumber_t sequenceNumber = SEQUENCENUMBER_UNKNOWN;
   PBufWrapper data;
+  // Small payloads are kept here instead of in a pbuf, see setPayload
+  std::array<uint8_t, Config::CACHE_CHANGE_INLINE_PAYLOAD_SIZE> inlinePayload;
+  DataSize_t inlineSize = 0;
 
   CacheChange &operator=(const CacheChange &other) = delete;
 
@@ -30,6 +37,8 @@ struct CacheChange {
 	  sentTickCount = other.sentTickCount;
 	  sequenceNumber = other.sequenceNumber;
 	  data = std::move(other.data);
+	  inlineSize = other.inlineSize;
+	  memcpy(inlinePayload.data(), other.inlinePayload.data(), inlineSize);
 	  return *this;
   }
 
@@ -43,9 +52,31 @@ struct CacheChange {
     inLineQoS = false;
     disposeAfterWrite = false;
     sentTickCount = 0;
+    inlineSize = 0;
   }
 
   bool isInitialized() { return (kind != ChangeKind_t::INVALID); }
+
+  //! Copies the payload. Payloads up to CACHE_CHANGE_INLINE_PAYLOAD_SIZE
+  //! bytes are stored inline so they do not occupy a pbuf.
+  bool setPayload(const uint8_t *payload, DataSize_t size) {
+    data.destroy();
+    inlineSize = 0;
+    if (size != 0 && size <= inlinePayload.size()) {
+      memcpy(inlinePayload.data(), payload, size);
+      inlineSize = size;
+      return true;
+    }
+    data.setPool(PBufPool::HISTORY);
+    data.reserve(size);
+    return data.append(payload, size) || size == 0;
+  }
+
+  bool hasInlinePayload() const { return inlineSize != 0; }
+
+  DataSize_t getDataSize() const {
+    return hasInlinePayload() ? inlineSize : data.spaceUsed();
+  }
 };
 
 }
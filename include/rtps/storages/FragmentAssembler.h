@@ -0,0 +1,210 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/pbuf.h"
+#include "rtps/common/types.h"
+#include "rtps/config.h"
+#include "rtps/utils/Diagnostics.h"
+
+#include <array>
+
+namespace rtps {
+
+/**
+ * Reassembles samples received as DATA_FRAG. Each sample in progress takes
+ * one slot holding a pbuf of the full sample size and a bitmap of the
+ * fragments received so far. If all slots are in use, the sample that was
+ * started first is dropped. The storage is not thread-safe and has to be
+ * guarded by the owner.
+ */
+template <uint8_t NUM_SLOTS> class FragmentAssembler {
+public:
+  ~FragmentAssembler() { clear(); }
+
+  /**
+   * Copies the fragments into the sample. Returns the pbuf of the sample once
+   * it is complete, the caller then owns it. Returns nullptr otherwise.
+   */
+  pbuf *addFragments(const Guid_t &writerGuid, const SequenceNumber_t &sn,
+                     uint32_t sampleSize, uint16_t fragmentSize,
+                     uint32_t firstFragment, uint16_t numFragments,
+                     const uint8_t *data, DataSize_t size) {
+    if (sampleSize == 0 || sampleSize > Config::MAX_FRAGMENTED_SAMPLE_SIZE ||
+        fragmentSize == 0 || firstFragment == 0) {
+      return nullptr;
+    }
+    const uint32_t totalFragments =
+        (sampleSize + fragmentSize - 1) / fragmentSize;
+    if (totalFragments > FNS_MAX_NUM_BITS ||
+        firstFragment + numFragments - 1 > totalFragments) {
+      return nullptr;
+    }
+
+    Slot *slot = find(writerGuid, sn);
+    if (slot == nullptr) {
+      slot = allocate(writerGuid, sn, sampleSize, fragmentSize);
+      if (slot == nullptr) {
+        return nullptr;
+      }
+    } else if (slot->sampleSize != sampleSize ||
+               slot->fragmentSize != fragmentSize) {
+      return nullptr;
+    }
+
+    for (uint16_t i = 0; i < numFragments; ++i) {
+      const uint32_t fragment = firstFragment + i;
+      const uint32_t offset = (fragment - 1) * fragmentSize;
+      const uint32_t length = sampleSize - offset < fragmentSize
+                                  ? sampleSize - offset
+                                  : fragmentSize;
+      const uint32_t dataOffset = static_cast<uint32_t>(i) * fragmentSize;
+      if (dataOffset + length > size) {
+        break;
+      }
+      if (slot->received.isSet(fragment - 1)) {
+        continue;
+      }
+      pbuf_take_at(slot->buffer, data + dataOffset,
+                   static_cast<uint16_t>(length),
+                   static_cast<uint16_t>(offset));
+      slot->received.set(fragment - 1);
+      ++slot->numReceived;
+    }
+
+    if (slot->numReceived < slot->numFragments) {
+      return nullptr;
+    }
+    pbuf *complete = slot->buffer;
+    slot->buffer = nullptr;
+    return complete;
+  }
+
+  /**
+   * Fills missing with the fragments up to lastFragment that have not been
+   * received yet. Returns false if none are missing.
+   */
+  bool getMissingFragments(const Guid_t &writerGuid,
+                           const SequenceNumber_t &sn, uint32_t lastFragment,
+                           FragmentNumberSet &missing) {
+    missing = FragmentNumberSet{};
+    const Slot *slot = find(writerGuid, sn);
+    if (slot != nullptr && lastFragment > slot->numFragments) {
+      lastFragment = slot->numFragments;
+    }
+    if (lastFragment > FNS_MAX_NUM_BITS) {
+      lastFragment = FNS_MAX_NUM_BITS;
+    }
+    for (uint32_t bit = 0; bit < lastFragment; ++bit) {
+      if (slot == nullptr || !slot->received.isSet(bit)) {
+        missing.set(bit);
+      }
+    }
+    return missing.numBits != 0;
+  }
+
+  //! Drops the samples of writerGuid, all of them if sn is unknown
+  void remove(const Guid_t &writerGuid,
+              const SequenceNumber_t &sn = SEQUENCENUMBER_UNKNOWN) {
+    for (auto &slot : m_slots) {
+      if (slot.buffer != nullptr && slot.writerGuid == writerGuid &&
+          (sn == SEQUENCENUMBER_UNKNOWN || slot.sn == sn)) {
+        release(slot);
+      }
+    }
+  }
+
+  void removeAllOfParticipant(const GuidPrefix_t &prefix) {
+    for (auto &slot : m_slots) {
+      if (slot.buffer != nullptr && slot.writerGuid.prefix == prefix) {
+        release(slot);
+      }
+    }
+  }
+
+  void clear() {
+    for (auto &slot : m_slots) {
+      release(slot);
+    }
+  }
+
+private:
+  struct Slot {
+    Guid_t writerGuid;
+    SequenceNumber_t sn;
+    uint32_t sampleSize = 0;
+    uint16_t fragmentSize = 0;
+    uint16_t numFragments = 0;
+    uint16_t numReceived = 0;
+    uint32_t age = 0;
+    FragmentNumberSet received;
+    pbuf *buffer = nullptr;
+  };
+
+  std::array<Slot, NUM_SLOTS> m_slots{};
+  uint32_t m_nextAge = 0;
+
+  Slot *find(const Guid_t &writerGuid, const SequenceNumber_t &sn) {
+    for (auto &slot : m_slots) {
+      if (slot.buffer != nullptr && slot.writerGuid == writerGuid &&
+          slot.sn == sn) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  Slot *allocate(const Guid_t &writerGuid, const SequenceNumber_t &sn,
+                 uint32_t sampleSize, uint16_t fragmentSize) {
+    Slot *target = nullptr;
+    for (auto &slot : m_slots) {
+      if (slot.buffer == nullptr) {
+        target = &slot;
+        break;
+      }
+      if (target == nullptr || slot.age < target->age) {
+        target = &slot;
+      }
+    }
+    if (target == nullptr) {
+      return nullptr;
+    }
+    if (target->buffer != nullptr) {
+      release(*target);
+      Diagnostics::Network::fragmented_samples_dropped++;
+    }
+
+    // Contiguous, the complete sample is handed to the reader as one pbuf
+    target->buffer = pbuf_alloc(PBUF_RAW, static_cast<uint16_t>(sampleSize),
+                                PBUF_RAM);
+    if (target->buffer == nullptr) {
+      return nullptr;
+    }
+    target->writerGuid = writerGuid;
+    target->sn = sn;
+    target->sampleSize = sampleSize;
+    target->fragmentSize = fragmentSize;
+    target->numFragments =
+        static_cast<uint16_t>((sampleSize + fragmentSize - 1) / fragmentSize);
+    target->numReceived = 0;
+    target->age = m_nextAge++;
+    target->received = FragmentNumberSet{};
+    return target;
+  }
+
+  void release(Slot &slot) {
+    if (slot.buffer != nullptr) {
+      pbuf_free(slot.buffer);
+      slot.buffer = nullptr;
+    }
+  }
+};
+
+} // namespace rtps
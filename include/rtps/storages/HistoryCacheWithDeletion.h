@@ -35,11 +35,24 @@ public:
   const CacheChange *addChange(const uint8_t *data, DataSize_t size,
                                bool inLineQoS, bool disposeAfterWrite) {
     CacheChange change;
+    change.setPayload(data, size);
+    return addChange(std::move(change), inLineQoS, disposeAfterWrite);
+  }
+
+  //! Takes over an already filled buffer without copying it
+  const CacheChange *addChange(PBufWrapper &&data, bool inLineQoS,
+                               bool disposeAfterWrite) {
+    CacheChange change;
+    change.data = std::move(data);
+    return addChange(std::move(change), inLineQoS, disposeAfterWrite);
+  }
+
+  //! Takes over the payload of change and assigns the next sequence number
+  const CacheChange *addChange(CacheChange &&change, bool inLineQoS,
+                               bool disposeAfterWrite) {
     change.kind = ChangeKind_t::ALIVE;
     change.inLineQoS = inLineQoS;
     change.disposeAfterWrite = disposeAfterWrite;
-    change.data.reserve(size);
-    change.data.append(data, size);
     change.sequenceNumber = ++m_lastUsedSequenceNumber;
 
     if (disposeAfterWrite) {
@@ -53,6 +66,22 @@ public:
     return place;
   }
 
+  //! Replaces the payload of sn with that of change, keeping the sequence
+  //! number
+  const CacheChange *replaceChange(const SequenceNumber_t &sn,
+                                   CacheChange &&change, bool inLineQoS) {
+    CacheChange *place = getChangeBySN(sn);
+    if (place == nullptr) {
+      return nullptr;
+    }
+    change.kind = ChangeKind_t::ALIVE;
+    change.inLineQoS = inLineQoS;
+    change.disposeAfterWrite = false;
+    change.sequenceNumber = sn;
+    *place = std::move(change);
+    return place;
+  }
+
   const CacheChange *addChange(const uint8_t *data, DataSize_t size) {
     return addChange(data, size, 0, false);
   }
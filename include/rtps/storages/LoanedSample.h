@@ -0,0 +1,53 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/pbuf.h"
+#include "rtps/common/types.h"
+#include "rtps/storages/PBufWrapper.h"
+
+namespace rtps {
+
+class Writer;
+
+/**
+ * Contiguous transmit buffer borrowed from a writer, see Writer::loanSample.
+ * The application serializes directly into data(), e.g. using
+ * ucdr_init_buffer(&mb, sample.data(), sample.capacity()), and hands it back
+ * with Writer::commitLoan. The buffer then becomes the payload of the cache
+ * change without being copied. Dropping the sample returns the memory.
+ */
+class LoanedSample {
+public:
+  LoanedSample() = default;
+  LoanedSample(LoanedSample &&other) noexcept = default;
+  LoanedSample &operator=(LoanedSample &&other) noexcept = default;
+
+  bool isValid() const { return m_buffer.isValid(); }
+
+  uint8_t *data() {
+    return isValid() ? static_cast<uint8_t *>(m_buffer.firstElement->payload)
+                     : nullptr;
+  }
+
+  DataSize_t capacity() const {
+    return isValid() ? m_buffer.firstElement->len : 0;
+  }
+
+private:
+  friend class Writer;
+
+  explicit LoanedSample(DataSize_t size)
+      : m_buffer(pbuf_alloc(PBUF_TRANSPORT, size, PBUF_RAM)) {}
+
+  PBufWrapper m_buffer;
+};
+
+} // namespace rtps
@@ -0,0 +1,40 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/pbuf.h"
+
+#include <cstdint>
+
+namespace rtps {
+
+//! Source of the memory of a PBufWrapper
+enum class PBufPool : uint8_t {
+  LWIP,     // lwIP's PBUF_POOL, shared with the receive path
+  USER_TX,  // Messages sent by user writers
+  META_TX,  // Messages sent by builtin writers
+  HISTORY,  // Payloads stored in writer histories
+};
+
+/**
+ * Allocates pbufs from dedicated slabs per traffic class, so discovery bursts
+ * cannot starve user data and vice versa. Each class has a small and a large
+ * size class, see Config::PBUF_SLAB_*. Requests that are too large or find
+ * their class exhausted fall back to PBUF_POOL.
+ */
+namespace PBufAllocator {
+
+pbuf *allocate(PBufPool pool, uint16_t length);
+
+//! Sum of the high-water marks of the slabs of pool
+uint8_t getMaxEverInUse(PBufPool pool);
+
+} // namespace PBufAllocator
+} // namespace rtps
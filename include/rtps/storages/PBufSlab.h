@@ -0,0 +1,102 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/pbuf.h"
+
+#include <array>
+#include <atomic>
+
+namespace rtps {
+
+/**
+ * Fixed number of equally sized pbufs outside of lwIP's PBUF_POOL. Elements
+ * are handed out as custom pbufs, pbuf_free() returns them to the slab.
+ * Each element has room for the protocol headers in front of ELEMENT_SIZE
+ * payload bytes, so lwIP can prepend them in place.
+ *
+ * Allocation and release are lock-free and can happen from any thread.
+ */
+template <uint16_t ELEMENT_SIZE, uint8_t NUM_ELEMENTS> class PBufSlab {
+public:
+  // In lwIP 2 the layer is the offset of the payload, which lwIP aligns
+  static constexpr uint16_t HEADER_ROOM =
+      (static_cast<uint16_t>(PBUF_TRANSPORT) + 3) & ~3;
+
+  PBufSlab() {
+    for (auto &element : m_elements) {
+      element.owner = this;
+#if LWIP_SUPPORT_CUSTOM_PBUF
+      element.custom.custom_free_function = &PBufSlab::release;
+#endif
+    }
+  }
+
+  PBufSlab(const PBufSlab &other) = delete;
+  PBufSlab &operator=(const PBufSlab &other) = delete;
+
+  //! Returns nullptr if length does not fit or all elements are in use
+  pbuf *allocate(uint16_t length) {
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    if (length > ELEMENT_SIZE) {
+      return nullptr;
+    }
+    for (auto &element : m_elements) {
+      bool expected = false;
+      if (!element.inUse.compare_exchange_strong(expected, true)) {
+        continue;
+      }
+      // PBUF_RAM marks the payload as contiguous with the header room
+      pbuf *result =
+          pbuf_alloced_custom(PBUF_TRANSPORT, length, PBUF_RAM,
+                              &element.custom, element.memory.data(),
+                              static_cast<uint16_t>(element.memory.size()));
+      if (result == nullptr) {
+        element.inUse = false;
+        return nullptr;
+      }
+      const uint8_t inUse = ++m_numInUse;
+      if (inUse > m_maxEverInUse) {
+        m_maxEverInUse = inUse;
+      }
+      return result;
+    }
+#else
+    (void)length;
+#endif
+    return nullptr;
+  }
+
+  uint8_t getNumInUse() const { return m_numInUse; }
+  //! High-water mark since startup
+  uint8_t getMaxEverInUse() const { return m_maxEverInUse; }
+  static constexpr uint8_t getNumElements() { return NUM_ELEMENTS; }
+
+private:
+  struct Element {
+    // Has to be the first member, the pbuf is cast back to the element
+    pbuf_custom custom;
+    PBufSlab *owner = nullptr;
+    std::atomic<bool> inUse{false};
+    alignas(4) std::array<uint8_t, HEADER_ROOM + ELEMENT_SIZE> memory;
+  };
+
+  std::array<Element, NUM_ELEMENTS> m_elements;
+  std::atomic<uint8_t> m_numInUse{0};
+  std::atomic<uint8_t> m_maxEverInUse{0};
+
+  static void release(pbuf *buffer) {
+    auto *element = reinterpret_cast<Element *>(buffer);
+    --element->owner->m_numInUse;
+    element->inUse = false;
+  }
+};
+
+} // namespace rtps
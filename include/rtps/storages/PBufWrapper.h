@@ -11,6 +11,7 @@
 
 #include "lwip/pbuf.h"
 #include "rtps/common/types.h"
+#include "rtps/storages/PBufAllocator.h"
 
 namespace rtps {
 
@@ -20,7 +21,7 @@ struct PBufWrapper {
 
   PBufWrapper() = default;
   explicit PBufWrapper(pbuf *bufferToWrap);
-  explicit PBufWrapper(DataSize_t length);
+  explicit PBufWrapper(DataSize_t length, PBufPool pool = PBufPool::LWIP);
 
   PBufWrapper(const PBufWrapper &other) = delete;
   PBufWrapper &operator=(const PBufWrapper &other) = delete;
@@ -38,8 +39,19 @@ struct PBufWrapper {
   /// append(uint8_t*[...]) will continue behind the appended wrapper
   void append(const PBufWrapper &other);
 
+  /// Copies the used bytes of other instead of chaining its pbufs. Required
+  /// when the same payload ends up in several messages that get modified
+  /// afterwards.
+  bool appendCopy(const PBufWrapper &other);
+  /// Copies length bytes of other, starting at offset
+  bool appendCopy(const PBufWrapper &other, DataSize_t offset,
+                  DataSize_t length);
+
   bool reserve(DataSize_t length);
 
+  /// Memory for subsequent reservations is taken from pool
+  void setPool(PBufPool pool);
+
   void destroy();
 
   /// After calling this function, data is added starting from the beginning
@@ -50,10 +62,8 @@ struct PBufWrapper {
   DataSize_t spaceUsed() const;
 
 private:
-  constexpr static pbuf_layer m_layer = PBUF_TRANSPORT;
-  constexpr static pbuf_type m_type = PBUF_POOL;
-
   DataSize_t m_freeSpace = 0;
+  PBufPool m_pool = PBufPool::LWIP;
 
   bool increaseSizeBy(uint16_t length);
 
@@ -0,0 +1,104 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/pbuf.h"
+#include "rtps/common/types.h"
+
+#include <array>
+
+namespace rtps {
+
+//! Sample that arrived before its predecessors. Keeps a reference to the
+//! received pbuf, data points into its payload.
+struct BufferedSample {
+  SequenceNumber_t sn;
+  ChangeKind_t kind = ChangeKind_t::INVALID;
+  pbuf *buffer = nullptr;
+  const uint8_t *data = nullptr;
+  DataSize_t size = 0;
+};
+
+/**
+ * Bounded storage for out-of-order samples of a single writer. Insertion
+ * takes a reference on the pbuf, release() and clear() give it back.
+ * The storage is not thread-safe and has to be guarded by the owner.
+ */
+template <uint8_t SIZE> class ReorderBuffer {
+public:
+  bool isEmpty() const { return m_numElements == 0; }
+  bool isFull() const { return m_numElements == SIZE; }
+
+  bool insert(const SequenceNumber_t &sn, ChangeKind_t kind, pbuf *buffer,
+              const uint8_t *data, DataSize_t size) {
+    if (buffer == nullptr || isFull() || find(sn) != nullptr) {
+      return false;
+    }
+    for (auto &sample : m_samples) {
+      if (sample.buffer == nullptr) {
+        pbuf_ref(buffer);
+        sample.sn = sn;
+        sample.kind = kind;
+        sample.buffer = buffer;
+        sample.data = data;
+        sample.size = size;
+        ++m_numElements;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  BufferedSample *find(const SequenceNumber_t &sn) {
+    if (isEmpty()) {
+      return nullptr;
+    }
+    for (auto &sample : m_samples) {
+      if (sample.buffer != nullptr && sample.sn == sn) {
+        return &sample;
+      }
+    }
+    return nullptr;
+  }
+
+  //! Returns the sample with the smallest sequence number
+  BufferedSample *findFirst() {
+    BufferedSample *first = nullptr;
+    for (auto &sample : m_samples) {
+      if (sample.buffer != nullptr &&
+          (first == nullptr || sample.sn < first->sn)) {
+        first = &sample;
+      }
+    }
+    return first;
+  }
+
+  void release(BufferedSample &sample) {
+    if (sample.buffer == nullptr) {
+      return;
+    }
+    pbuf_free(sample.buffer);
+    sample.buffer = nullptr;
+    sample.data = nullptr;
+    --m_numElements;
+  }
+
+  void clear() {
+    for (auto &sample : m_samples) {
+      release(sample);
+    }
+  }
+
+private:
+  std::array<BufferedSample, SIZE> m_samples{};
+  uint8_t m_numElements = 0;
+};
+
+} // namespace rtps
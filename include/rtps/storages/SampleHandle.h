@@ -0,0 +1,62 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/pbuf.h"
+#include "rtps/common/types.h"
+
+namespace rtps {
+
+/**
+ * Keeps a received sample alive beyond the reader callback without copying
+ * it. The handle holds a reference on the receive pbuf and views size bytes
+ * at offset into its payload. Copies share the pbuf, the last one to go
+ * away returns it to lwIP.
+ *
+ * Every pbuf held this way is missing in the receive pool. The number of
+ * live handles is therefore limited to Config::MAX_RETAINED_SAMPLES,
+ * creating more results in an invalid handle.
+ */
+class SampleHandle {
+public:
+  ChangeKind_t kind = ChangeKind_t::INVALID;
+  Guid_t writerGuid{};
+  SequenceNumber_t sn{};
+
+  SampleHandle() = default;
+  SampleHandle(ChangeKind_t kind, const Guid_t &writerGuid,
+               const SequenceNumber_t &sn, pbuf *buffer, const uint8_t *data,
+               DataSize_t size);
+  ~SampleHandle();
+
+  SampleHandle(const SampleHandle &other);
+  SampleHandle(SampleHandle &&other) noexcept;
+  SampleHandle &operator=(const SampleHandle &other);
+  SampleHandle &operator=(SampleHandle &&other) noexcept;
+
+  bool isValid() const { return m_buffer != nullptr; }
+  const uint8_t *getData() const;
+  DataSize_t getDataSize() const { return m_size; }
+  pbuf *getPbuf() const { return m_buffer; }
+  //! Drops the reference early
+  void reset();
+
+  //! Number of pbufs currently held by handles
+  static uint16_t getNumRetainedBuffers();
+
+private:
+  pbuf *m_buffer = nullptr;
+  uint16_t m_offset = 0;
+  DataSize_t m_size = 0;
+
+  void acquire(pbuf *buffer);
+};
+
+} // namespace rtps
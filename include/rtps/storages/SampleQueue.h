@@ -0,0 +1,213 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "lwip/sys.h"
+#include "rtps/storages/SampleHandle.h"
+#include "rtps/utils/Lock.h"
+
+#include <array>
+
+namespace rtps {
+
+/**
+ * Bounded KEEP_LAST queue between the receive thread and the application.
+ * The receive thread only pushes sample handles, application threads take
+ * them at their own pace. If depth samples are queued already, the oldest
+ * one is dropped. With per-writer conflation, a queued sample is replaced by
+ * the next one of the same writer, so each writer occupies a single entry.
+ *
+ * A listener semaphore, e.g. the one of a WaitSet, is signaled for each
+ * queued sample in addition to the own one.
+ */
+template <uint8_t SIZE> class SampleQueue {
+public:
+  ~SampleQueue() {
+    if (sys_sem_valid(&m_notEmpty)) {
+      sys_sem_free(&m_notEmpty);
+    }
+  }
+
+  //! depth 0 disables the queue and drops everything queued
+  bool init(uint8_t depth, bool conflatePerWriter) {
+    if (depth > SIZE) {
+      return false;
+    }
+    if (m_mutex == nullptr && !createMutex(&m_mutex)) {
+      return false;
+    }
+    if (!sys_sem_valid(&m_notEmpty) &&
+        sys_sem_new(&m_notEmpty, 0) != ERR_OK) {
+      return false;
+    }
+
+    Lock lock{m_mutex};
+    for (auto &sample : m_samples) {
+      sample.reset();
+    }
+    m_first = 0;
+    m_numElements = 0;
+    m_depth = depth;
+    m_conflatePerWriter = conflatePerWriter;
+    return true;
+  }
+
+  bool isEnabled() const { return m_depth != 0; }
+
+  //! Returns false if the sample could not be queued
+  bool push(SampleHandle &&sample) {
+    if (!isEnabled()) {
+      return false;
+    }
+    if (!sample.isValid()) {
+      // Retaining failed, too many samples are held already
+      ++m_numRejected;
+      return false;
+    }
+
+    sys_sem_t *listener = nullptr;
+    {
+      Lock lock{m_mutex};
+      if (m_conflatePerWriter) {
+        for (uint8_t i = 0; i < m_numElements; ++i) {
+          SampleHandle &queued = m_samples[(m_first + i) % SIZE];
+          if (queued.writerGuid == sample.writerGuid) {
+            queued = std::move(sample);
+            ++m_numConflated;
+            return true;
+          }
+        }
+      }
+
+      if (m_numElements == m_depth) {
+        m_samples[m_first].reset();
+        m_first = (m_first + 1) % SIZE;
+        --m_numElements;
+        ++m_numOverflows;
+      }
+      m_samples[(m_first + m_numElements) % SIZE] = std::move(sample);
+      ++m_numElements;
+      listener = m_listener;
+    }
+    sys_sem_signal(&m_notEmpty);
+    if (listener != nullptr) {
+      sys_sem_signal(listener);
+    }
+    return true;
+  }
+
+  //! Takes the oldest sample. Waits up to timeoutMs if the queue is empty.
+  bool take(SampleHandle &sample, uint32_t timeoutMs) {
+    if (!isEnabled()) {
+      return false;
+    }
+    while (true) {
+      {
+        Lock lock{m_mutex};
+        if (m_numElements != 0) {
+          popFirst(sample);
+          return true;
+        }
+      }
+      if (timeoutMs == 0) {
+        return false;
+      }
+      // Signals of samples taken in the meantime wake us up without a
+      // sample, so wait again for what is left of the timeout
+      const uint32_t waited = sys_arch_sem_wait(&m_notEmpty, timeoutMs);
+      if (waited == SYS_ARCH_TIMEOUT || waited >= timeoutMs) {
+        timeoutMs = 0;
+      } else {
+        timeoutMs -= waited;
+      }
+    }
+  }
+
+  //! Takes up to maxSamples, waiting up to timeoutMs for the first one.
+  //! Returns the number of samples taken.
+  uint8_t take(SampleHandle *samples, uint8_t maxSamples, uint32_t timeoutMs) {
+    if (samples == nullptr || maxSamples == 0 ||
+        !take(samples[0], timeoutMs)) {
+      return 0;
+    }
+    Lock lock{m_mutex};
+    uint8_t numTaken = 1;
+    while (numTaken < maxSamples && m_numElements != 0) {
+      popFirst(samples[numTaken++]);
+    }
+    return numTaken;
+  }
+
+  //! Copies up to maxSamples handles, oldest first, without removing them.
+  //! Copies beyond Config::MAX_RETAINED_SAMPLES are invalid.
+  uint8_t read(SampleHandle *samples, uint8_t maxSamples) {
+    if (samples == nullptr || !isEnabled()) {
+      return 0;
+    }
+    Lock lock{m_mutex};
+    uint8_t numRead = 0;
+    while (numRead < maxSamples && numRead < m_numElements) {
+      samples[numRead] = m_samples[(m_first + numRead) % SIZE];
+      ++numRead;
+    }
+    return numRead;
+  }
+
+  bool hasSamples() {
+    if (!isEnabled()) {
+      return false;
+    }
+    Lock lock{m_mutex};
+    return m_numElements != 0;
+  }
+
+  //! Only one listener at a time, nullptr removes it
+  bool setListener(sys_sem_t *listener) {
+    if (m_mutex == nullptr) {
+      return false;
+    }
+    Lock lock{m_mutex};
+    if (listener != nullptr && m_listener != nullptr &&
+        m_listener != listener) {
+      return false;
+    }
+    m_listener = listener;
+    return true;
+  }
+
+  //! Samples dropped because the queue was full
+  uint32_t getNumOverflows() const { return m_numOverflows; }
+  //! Samples replaced by a newer one of the same writer
+  uint32_t getNumConflated() const { return m_numConflated; }
+  //! Samples dropped because they could not be retained
+  uint32_t getNumRejected() const { return m_numRejected; }
+
+private:
+  SemaphoreHandle_t m_mutex = nullptr;
+  sys_sem_t m_notEmpty{};
+  sys_sem_t *m_listener = nullptr;
+  std::array<SampleHandle, SIZE> m_samples{};
+  uint8_t m_first = 0;
+  uint8_t m_numElements = 0;
+  uint8_t m_depth = 0;
+  bool m_conflatePerWriter = false;
+
+  uint32_t m_numOverflows = 0;
+  uint32_t m_numConflated = 0;
+  uint32_t m_numRejected = 0;
+
+  void popFirst(SampleHandle &sample) {
+    sample = std::move(m_samples[m_first]);
+    m_first = (m_first + 1) % SIZE;
+    --m_numElements;
+  }
+};
+
+} // namespace rtps
@@ -0,0 +1,111 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include "rtps/config.h"
+#include "ucdr/microcdr.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace rtps {
+namespace ArrayKernels {
+
+/**
+ * Copies count words of wordSize bytes (1, 2, 4 or 8) and reverses the byte
+ * order of each. dst and src may be the same, but must not overlap
+ * otherwise. Uses SSE2 or AVX2 on x86 builds and a scalar loop elsewhere.
+ */
+void copySwapped(void *dst, const void *src, size_t count, size_t wordSize);
+
+inline ucdrEndianness getNativeEndianness() {
+#if IS_LITTLE_ENDIAN
+  return UCDR_LITTLE_ENDIANNESS;
+#else
+  return UCDR_BIG_ENDIANNESS;
+#endif
+}
+
+/**
+ * Bulk replacements for ucdr_(de)serialize_array_* of numeric types. The
+ * wire format is the same, but the byte order of the whole array is
+ * converted at once instead of element by element.
+ */
+template <typename T>
+bool serializeArray(ucdrBuffer &buffer, const T *values, size_t count) {
+  static_assert(std::is_arithmetic<T>::value &&
+                    (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+                "Only 2, 4 and 8 byte numbers are supported");
+  const size_t size = count * sizeof(T);
+  ucdr_align_to(&buffer, sizeof(T));
+  if (buffer.error || ucdr_buffer_remaining(&buffer) < size) {
+    buffer.error = true;
+    return false;
+  }
+
+  if (buffer.endianness == getNativeEndianness()) {
+    memcpy(buffer.iterator, values, size);
+  } else {
+    copySwapped(buffer.iterator, values, count, sizeof(T));
+  }
+  buffer.last_data_size = sizeof(T);
+  ucdr_advance_buffer(&buffer, size);
+  return !buffer.error;
+}
+
+template <typename T>
+bool deserializeArray(ucdrBuffer &buffer, T *values, size_t count) {
+  static_assert(std::is_arithmetic<T>::value &&
+                    (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+                "Only 2, 4 and 8 byte numbers are supported");
+  const size_t size = count * sizeof(T);
+  ucdr_align_to(&buffer, sizeof(T));
+  if (buffer.error || ucdr_buffer_remaining(&buffer) < size) {
+    buffer.error = true;
+    return false;
+  }
+
+  if (buffer.endianness == getNativeEndianness()) {
+    memcpy(values, buffer.iterator, size);
+  } else {
+    copySwapped(values, buffer.iterator, count, sizeof(T));
+  }
+  buffer.last_data_size = sizeof(T);
+  ucdr_advance_buffer(&buffer, size);
+  return !buffer.error;
+}
+
+/**
+ * CDR sequence of numbers, the length followed by the elements. Fails
+ * without touching values if the received length exceeds capacity.
+ */
+template <typename T>
+bool serializeSequence(ucdrBuffer &buffer, const T *values, uint32_t length) {
+  return ucdr_serialize_uint32_t(&buffer, length) &&
+         serializeArray(buffer, values, length);
+}
+
+template <typename T>
+bool deserializeSequence(ucdrBuffer &buffer, T *values, uint32_t capacity,
+                         uint32_t &length) {
+  if (!ucdr_deserialize_uint32_t(&buffer, &length)) {
+    return false;
+  }
+  if (length > capacity) {
+    buffer.error = true;
+    return false;
+  }
+  return deserializeArray(buffer, values, length);
+}
+
+} // namespace ArrayKernels
+} // namespace rtps
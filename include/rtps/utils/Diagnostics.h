@@ -36,10 +36,51 @@ extern uint32_t max_ever_elements_incoming_metatraffic_queue;
 namespace StatefulReader {
 extern uint32_t sfr_unexpected_sn;
 extern uint32_t sfr_retransmit_requests;
+extern uint32_t sfr_buffered_out_of_order;
+extern uint32_t sfr_reorder_buffer_overflows;
+extern uint32_t sfr_acknacks_merged;
+extern uint32_t sfr_acknack_messages_sent;
+extern uint32_t sfr_delta_samples_dropped;
 } // namespace StatefulReader
 
+namespace StatefulWriter {
+extern uint32_t sfw_data_bytes_sent;
+extern uint32_t sfw_repair_bytes_sent;
+extern uint32_t sfw_nacks_merged;
+extern uint32_t sfw_multicast_repairs;
+extern uint32_t sfw_conflated_samples;
+extern uint32_t sfw_delta_samples;
+extern uint32_t sfw_key_frames;
+extern uint32_t sfw_delta_bytes_saved;
+} // namespace StatefulWriter
+
+namespace StatelessWriter {
+extern uint32_t slw_conflated_samples;
+} // namespace StatelessWriter
+
+namespace Compression {
+extern uint32_t compressed_samples;
+extern uint32_t compression_bytes_saved;
+extern uint32_t compression_time_us;
+extern uint32_t decompressed_samples;
+extern uint32_t decompression_time_us;
+extern uint32_t decompression_failures;
+} // namespace Compression
+
+namespace FlowControl {
+extern uint32_t paced_transmissions;
+extern uint32_t pacing_delay_ms;
+} // namespace FlowControl
+
 namespace Network {
 extern uint32_t lwip_allocation_failures;
+extern uint32_t aggregated_submessages;
+extern uint32_t retained_samples_rejected;
+extern uint32_t slab_fallback_allocations;
+extern uint32_t fragmented_samples_dropped;
+extern uint32_t unaligned_plain_samples;
+extern uint32_t intra_process_samples;
+extern uint32_t udp_local_bypass_packets;
 }
 
 namespace OS {
@@ -0,0 +1,36 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace rtps {
+namespace Lz4 {
+
+/**
+ * Compressor for the LZ4 block format, without the frame format around it.
+ * Single pass with a small hash table and no entropy stage, so it is cheap
+ * enough for the writing thread. Inputs are limited to 64 KiB, which covers
+ * every payload a cache change can hold.
+ *
+ * Returns the compressed size or 0 if the result does not fit into
+ * dstCapacity. Passing a capacity below the input size thereby skips
+ * results that would not save anything.
+ */
+uint32_t compress(const uint8_t *src, uint32_t srcSize, uint8_t *dst,
+                  uint32_t dstCapacity);
+
+//! Returns the decompressed size or 0 if src is malformed or does not fit
+//! into dstCapacity
+uint32_t decompress(const uint8_t *src, uint32_t srcSize, uint8_t *dst,
+                    uint32_t dstCapacity);
+
+} // namespace Lz4
+} // namespace rtps
@@ -0,0 +1,36 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace rtps {
+namespace XorDelta {
+
+/**
+ * Encodes current as difference to base, both of them size bytes. The
+ * result is a sequence of runs, each made of the number of unchanged bytes
+ * to skip, the number of changed bytes and the changed bytes XORed with the
+ * base. Unchanged bytes at the end are not encoded at all, so identical
+ * inputs result in an empty delta.
+ *
+ * Returns false if the result does not fit into dstCapacity, otherwise
+ * encodedSize holds its size.
+ */
+bool encode(const uint8_t *base, const uint8_t *current, uint32_t size,
+            uint8_t *dst, uint32_t dstCapacity, uint32_t &encodedSize);
+
+//! Restores size bytes from base and delta. Returns false if delta is
+//! malformed or reaches beyond size.
+bool decode(const uint8_t *base, const uint8_t *delta, uint32_t deltaSize,
+            uint8_t *dst, uint32_t size);
+
+} // namespace XorDelta
+} // namespace rtps
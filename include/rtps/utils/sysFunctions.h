@@ -12,6 +12,12 @@
 #include "lwip/sys.h"
 #include "rtps/common/types.h"
 
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <chrono>
+#endif
+
 namespace rtps {
 
 inline Time_t getCurrentTimeStamp() {
@@ -23,4 +29,16 @@ inline Time_t getCurrentTimeStamp() {
   return now;
 }
 
+//! Wraps around, only meant for measuring short durations
+inline uint32_t getMicroseconds() {
+#ifdef ESP_PLATFORM
+  return static_cast<uint32_t>(esp_timer_get_time());
+#else
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
 }
@@ -0,0 +1,159 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/CallbackExecutor.h"
+
+#include "rtps/entities/Reader.h"
+
+using rtps::CallbackExecutor;
+
+CallbackExecutor::~CallbackExecutor() {
+  stop();
+  for (auto &worker : m_workers) {
+    if (sys_sem_valid(&worker.signal)) {
+      sys_sem_free(&worker.signal);
+    }
+  }
+}
+
+bool CallbackExecutor::start() {
+  if (m_running) {
+    return true;
+  }
+  if (m_producerMutex == nullptr && !createMutex(&m_producerMutex)) {
+    return false;
+  }
+  for (auto &worker : m_workers) {
+    if (!sys_sem_valid(&worker.signal) &&
+        sys_sem_new(&worker.signal, 0) != ERR_OK) {
+      return false;
+    }
+  }
+
+  m_running = true;
+  for (auto &worker : m_workers) {
+    worker.executor = this;
+    const sys_thread_t thread = sys_thread_new(
+        "CallbackExecutor", workerFunction, &worker,
+        Config::CALLBACK_EXECUTOR_STACKSIZE, Config::CALLBACK_EXECUTOR_PRIO);
+    if (thread == nullptr) {
+      // Workers started so far leave their loop once they are signaled
+      stop();
+      return false;
+    }
+  }
+  return true;
+}
+
+void CallbackExecutor::stop() {
+  if (!m_running) {
+    return;
+  }
+  m_running = false;
+  for (auto &worker : m_workers) {
+    sys_sem_signal(&worker.signal);
+  }
+  // Same as for the thread pool, there is no join
+  sys_msleep(10);
+}
+
+bool CallbackExecutor::dispatch(Reader &reader, uint32_t callbackIdentifier,
+                                const ReaderCacheChange &cacheChange) {
+  if (!m_running) {
+    return false;
+  }
+
+  const auto key = reinterpret_cast<uintptr_t>(&reader);
+  Worker &worker = m_workers[(key / alignof(Reader)) % m_workers.size()];
+  const uint8_t size = worker.jobs.size();
+  {
+    Lock lock{m_producerMutex};
+    const uint8_t tail = worker.tail.load(std::memory_order_relaxed);
+    const uint8_t head = worker.head.load(std::memory_order_acquire);
+    const uint8_t next = (tail + 1) % size;
+    const uint8_t depth = (tail + size - head) % size;
+    m_queueDepth[getBucket(depth)].fetch_add(1, std::memory_order_relaxed);
+
+    Job &job = worker.jobs[tail];
+    if (next == head) {
+      m_numDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    job.sample = cacheChange.retain();
+    if (!job.sample.isValid()) {
+      m_numDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    job.reader = &reader;
+    job.callbackIdentifier = callbackIdentifier;
+    worker.tail.store(next, std::memory_order_release);
+  }
+  sys_sem_signal(&worker.signal);
+  return true;
+}
+
+void CallbackExecutor::workerFunction(void *arg) {
+  auto *worker = static_cast<Worker *>(arg);
+  worker->executor->run(*worker);
+}
+
+void CallbackExecutor::run(Worker &worker) {
+  const uint8_t size = worker.jobs.size();
+  while (m_running) {
+    sys_sem_wait(&worker.signal);
+
+    uint8_t head = worker.head.load(std::memory_order_relaxed);
+    while (head != worker.tail.load(std::memory_order_acquire)) {
+      Job &job = worker.jobs[head];
+      const SampleHandle &sample = job.sample;
+      const ReaderCacheChange cacheChange{sample.kind,      sample.writerGuid,
+                                          sample.sn,        sample.getData(),
+                                          sample.getDataSize(),
+                                          sample.getPbuf()};
+
+      const uint32_t start = sys_now();
+      job.reader->executeDeferredCallback(job.callbackIdentifier,
+                                          cacheChange);
+      m_callbackDuration[getBucket(sys_now() - start)].fetch_add(
+          1, std::memory_order_relaxed);
+
+      job.sample.reset();
+      head = (head + 1) % size;
+      worker.head.store(head, std::memory_order_release);
+    }
+  }
+}
+
+uint8_t CallbackExecutor::getBucket(uint32_t value) {
+  uint8_t bucket = 0;
+  while (value != 0 &&
+         bucket + 1 < Config::CALLBACK_EXECUTOR_HISTOGRAM_BUCKETS) {
+    value >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+CallbackExecutor::Histogram
+CallbackExecutor::toHistogram(const AtomicHistogram &histogram) {
+  Histogram result{};
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    result[i] = histogram[i].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+CallbackExecutor::Histogram CallbackExecutor::getQueueDepthHistogram() const {
+  return toHistogram(m_queueDepth);
+}
+
+CallbackExecutor::Histogram
+CallbackExecutor::getCallbackDurationHistogram() const {
+  return toHistogram(m_callbackDuration);
+}
@@ -32,8 +32,12 @@ using rtps::ThreadPool;
 #define THREAD_POOL_LOG(...) //
 #endif
 
-ThreadPool::ThreadPool(receiveJumppad_fp receiveCallback, void *callee)
-    : m_receiveJumppad(receiveCallback), m_callee(callee) {
+ThreadPool::ThreadPool(receiveJumppad_fp receiveCallback, void *callee,
+                       deferredWorkJumppad_fp deferredWorkCallback,
+                       deferredWorkJumppad_fp deferredTransmitCallback)
+    : m_receiveJumppad(receiveCallback),
+      m_deferredWorkJumppad(deferredWorkCallback),
+      m_deferredTransmitJumppad(deferredTransmitCallback), m_callee(callee) {
 
   if (!m_outgoingMetaTraffic.init() || !m_outgoingUserTraffic.init() ||
       !m_incomingMetaTraffic.init() || !m_incomingUserTraffic.init()) {
@@ -227,6 +231,11 @@ void ThreadPool::doWriterWork() {
       Diagnostics::ThreadPool::processed_outgoing_metatraffic++;
     }
 
+    uint32_t deferredTransmitTimeoutMs = 0;
+    if (m_deferredTransmitJumppad != nullptr) {
+      deferredTransmitTimeoutMs = m_deferredTransmitJumppad(m_callee);
+    }
+
     if (workload_usertraffic_available || workload_metatraffic_available) {
       continue;
     } else {
@@ -234,7 +243,11 @@ void ThreadPool::doWriterWork() {
                       static_cast<unsigned int>(Diagnostics::ThreadPool::processed_outgoing_usertraffic),
                       static_cast<unsigned int>(Diagnostics::ThreadPool::processed_outgoing_metatraffic));
       updateDiagnostics();
-      sys_sem_wait(&m_writerNotificationSem);
+      if (deferredTransmitTimeoutMs != 0) {
+        sys_arch_sem_wait(&m_writerNotificationSem, deferredTransmitTimeoutMs);
+      } else {
+        sys_sem_wait(&m_writerNotificationSem);
+      }
     }
   }
 }
@@ -297,6 +310,12 @@ void ThreadPool::doReaderWork() {
       m_receiveJumppad(m_callee, const_cast<const PacketInfo &>(packet_meta));
     }
 
+    // Runs on every iteration, a busy queue must not delay due work
+    uint32_t deferredWorkTimeoutMs = 0;
+    if (m_deferredWorkJumppad != nullptr) {
+      deferredWorkTimeoutMs = m_deferredWorkJumppad(m_callee);
+    }
+
     if (isUserWorkToDo || isMetaWorkToDo) {
       continue;
     }
@@ -304,7 +323,11 @@ void ThreadPool::doReaderWork() {
                     static_cast<unsigned int>(usertraffic),
                     static_cast<unsigned int>(metatraffic));
     updateDiagnostics();
-    sys_sem_wait(&m_readerNotificationSem);
+    if (deferredWorkTimeoutMs != 0) {
+      sys_arch_sem_wait(&m_readerNotificationSem, deferredWorkTimeoutMs);
+    } else {
+      sys_sem_wait(&m_readerNotificationSem);
+    }
   }
 }
 
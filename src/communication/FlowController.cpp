@@ -0,0 +1,96 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/communication/FlowController.h"
+
+#include "rtps/config.h"
+#include "rtps/utils/Lock.h"
+
+#include <algorithm>
+
+using rtps::FlowController;
+using rtps::TokenBucket;
+
+void TokenBucket::init(uint32_t ratePerSecond, uint32_t burst) {
+  m_rate = ratePerSecond;
+  m_burst = burst;
+  m_tokens = burst;
+  m_lastRefill = xTaskGetTickCount();
+}
+
+void TokenBucket::refill(TickType_t now) {
+  const TickType_t elapsed = now - m_lastRefill;
+  const int64_t newTokens =
+      static_cast<int64_t>(elapsed) * m_rate / configTICK_RATE_HZ;
+  if (newTokens == 0) {
+    // Keep the remainder for the next call
+    return;
+  }
+  if (m_tokens + newTokens >= m_burst) {
+    // Nothing can be saved up beyond the burst
+    m_tokens = m_burst;
+    m_lastRefill = now;
+    return;
+  }
+  m_tokens += newTokens;
+  // Only the ticks that made up whole tokens are used, rounded up so that
+  // the rate is never exceeded. The fraction counts towards the next call.
+  m_lastRefill += static_cast<TickType_t>(
+      (newTokens * configTICK_RATE_HZ + m_rate - 1) / m_rate);
+}
+
+uint32_t TokenBucket::consume(uint32_t amount, TickType_t now) {
+  if (isUnlimited()) {
+    return 0;
+  }
+
+  refill(now);
+  m_tokens -= amount;
+  if (m_tokens >= 0) {
+    return 0;
+  }
+
+  const int64_t debt = -m_tokens;
+  return static_cast<uint32_t>((debt * 1000 + m_rate - 1) / m_rate);
+}
+
+bool FlowController::init(const FlowControlSettings &settings) {
+  if (m_mutex == nullptr && !createMutex(&m_mutex)) {
+    return false;
+  }
+
+  Lock lock{m_mutex};
+  // Allow short bursts but at least a single full packet
+  const uint32_t byteBurst =
+      std::max<uint32_t>(static_cast<uint64_t>(settings.bytesPerSecond) *
+                             Config::FLOW_CONTROL_MAX_BURST_MS / 1000,
+                         Config::FLOW_CONTROL_MIN_BURST_BYTES);
+  const uint32_t packetBurst = std::max<uint32_t>(
+      static_cast<uint64_t>(settings.packetsPerSecond) *
+          Config::FLOW_CONTROL_MAX_BURST_MS / 1000,
+      1);
+  m_bytes.init(settings.bytesPerSecond, byteBurst);
+  m_packets.init(settings.packetsPerSecond, packetBurst);
+  return true;
+}
+
+bool FlowController::isUnlimited() const {
+  return m_bytes.isUnlimited() && m_packets.isUnlimited();
+}
+
+uint32_t FlowController::reserve(uint32_t bytes, uint32_t packets) {
+  if (m_mutex == nullptr || isUnlimited()) {
+    return 0;
+  }
+
+  Lock lock{m_mutex};
+  const TickType_t now = xTaskGetTickCount();
+  return std::max(m_bytes.consume(bytes, now),
+                  m_packets.consume(packets, now));
+}
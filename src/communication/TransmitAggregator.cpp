@@ -0,0 +1,156 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/communication/TransmitAggregator.h"
+
+#include "rtps/messages/MessageFactory.h"
+#include "rtps/utils/Diagnostics.h"
+
+using rtps::TransmitAggregator;
+
+bool TransmitAggregator::init(const GuidPrefix_t &guidPrefix,
+                              uint16_t windowMs) {
+  if (m_mutex == nullptr && !createMutex(&m_mutex)) {
+    return false;
+  }
+
+  Lock lock{m_mutex};
+  for (auto &message : m_messages) {
+    message.inUse = false;
+    message.info.buffer.destroy();
+  }
+  m_guidPrefix = guidPrefix;
+  m_window = pdMS_TO_TICKS(windowMs);
+  return true;
+}
+
+void TransmitAggregator::setSender(sendJumppad_fp sendCallback,
+                                   void *callee) {
+  m_sendJumppad = sendCallback;
+  m_callee = callee;
+}
+
+bool TransmitAggregator::isEnabled() const {
+  return m_mutex != nullptr && m_window != 0 && m_sendJumppad != nullptr;
+}
+
+rtps::PBufWrapper *TransmitAggregator::prepare(const LocatorIPv4 &destination,
+                                               Ip4Port_t srcPort,
+                                               DataSize_t size) {
+  const TickType_t now = xTaskGetTickCount();
+  PendingMessage *target = nullptr;
+  PendingMessage *oldest = nullptr;
+  PendingMessage *unused = nullptr;
+  for (auto &message : m_messages) {
+    if (!message.inUse) {
+      if (unused == nullptr) {
+        unused = &message;
+      }
+      continue;
+    }
+    if (message.destination == destination &&
+        message.info.srcPort == srcPort) {
+      target = &message;
+      break;
+    }
+    if (oldest == nullptr ||
+        now - message.opened > now - oldest->opened) {
+      oldest = &message;
+    }
+  }
+
+  if (target != nullptr && target->info.buffer.spaceUsed() + size >
+                               Config::MAX_RTPS_MESSAGE_SIZE) {
+    // Full, send what we have and start over for the same destination
+    send(*target);
+  } else if (target == nullptr) {
+    if (unused == nullptr) {
+      // Too many destinations at once, make room by sending the oldest
+      send(*oldest);
+      unused = oldest;
+    }
+    target = unused;
+  }
+
+  if (!target->inUse) {
+    target->info.buffer.setPool(PBufPool::USER_TX);
+    target->info.srcPort = srcPort;
+    target->info.destAddr = destination.getIp4Address();
+    target->info.destPort = static_cast<Ip4Port_t>(destination.port);
+    MessageFactory::addHeader(target->info.buffer, m_guidPrefix);
+    MessageFactory::addSubMessageTimeStamp(target->info.buffer);
+    if (!target->info.buffer.isValid()) {
+      return nullptr;
+    }
+    target->destination = destination;
+    target->opened = now;
+    target->inUse = true;
+  } else {
+    Diagnostics::Network::aggregated_submessages++;
+  }
+
+  return &target->info.buffer;
+}
+
+void TransmitAggregator::send(PendingMessage &message) {
+  if (!message.inUse) {
+    return;
+  }
+  m_sendJumppad(m_callee, message.info);
+  message.info.buffer.destroy();
+  message.inUse = false;
+}
+
+TickType_t TransmitAggregator::flushDue(TickType_t now) {
+  if (!isEnabled()) {
+    return 0;
+  }
+
+  Lock lock{m_mutex};
+  TickType_t waitTicks = 0;
+  for (auto &message : m_messages) {
+    if (!message.inUse) {
+      continue;
+    }
+    const TickType_t age = now - message.opened;
+    if (age >= m_window) {
+      send(message);
+    } else if (waitTicks == 0 || m_window - age < waitTicks) {
+      waitTicks = m_window - age;
+    }
+  }
+  return waitTicks;
+}
+
+void TransmitAggregator::flush(const LocatorIPv4 &destination,
+                               Ip4Port_t srcPort) {
+  if (!isEnabled()) {
+    return;
+  }
+
+  Lock lock{m_mutex};
+  for (auto &message : m_messages) {
+    if (message.inUse && message.destination == destination &&
+        message.info.srcPort == srcPort) {
+      send(message);
+      return;
+    }
+  }
+}
+
+void TransmitAggregator::flushAll() {
+  if (m_mutex == nullptr) {
+    return;
+  }
+
+  Lock lock{m_mutex};
+  for (auto &message : m_messages) {
+    send(message);
+  }
+}
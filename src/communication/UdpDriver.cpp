@@ -10,6 +10,7 @@
 #include "rtps/communication/UdpDriver.h"
 
 #include "rtps/communication/TcpipCoreLock.h"
+#include "rtps/utils/Diagnostics.h"
 #include "rtps/utils/Lock.h"
 #include "rtps/utils/Log.h"
 
@@ -38,10 +39,9 @@ UdpDriver::UdpDriver(rtps::UdpDriver::udpRxFunc_fp callback, void *args)
 
 const rtps::UdpConnection *
 UdpDriver::createUdpConnection(Ip4Port_t receivePort) {
-  for (uint8_t i = 0; i < m_numConns; ++i) {
-    if (m_conns[i].port == receivePort) {
-      return &m_conns[i];
-    }
+  const UdpConnection *existing = findConnection(receivePort);
+  if (existing != nullptr) {
+    return existing;
   }
 
   if (m_numConns == m_conns.size()) {
@@ -71,6 +71,15 @@ UdpDriver::createUdpConnection(Ip4Port_t receivePort) {
   return &m_conns[m_numConns - 1];
 }
 
+const rtps::UdpConnection *UdpDriver::findConnection(Ip4Port_t port) const {
+  for (uint8_t i = 0; i < m_numConns; ++i) {
+    if (m_conns[i].port == port) {
+      return &m_conns[i];
+    }
+  }
+  return nullptr;
+}
+
 bool UdpDriver::isSameSubnet(const IPAddress& addr) {
   return ((uint32_t)Config::NETMASK & (uint32_t)addr) ==
          ((uint32_t)Config::NETMASK & (uint32_t)Config::ADDRESS);
@@ -119,7 +128,44 @@ bool UdpDriver::sendPacket(const UdpConnection &conn, const IPAddress &destAddr,
   return true;
 }
 
+bool UdpDriver::deliverLocally(PacketInfo &packet) {
+  if (!Config::UDP_LOCAL_BYPASS || !(packet.destAddr == Config::ADDRESS)) {
+    return false;
+  }
+  const UdpConnection *conn = findConnection(packet.destPort);
+  if (conn == nullptr || !packet.buffer.isValid()) {
+    return false;
+  }
+
+  // The receive callback takes ownership like for packets from lwIP. A
+  // single pbuf gets another reference, the sender keeps its own. Messages
+  // are usually chained though and the receive path needs them in one
+  // piece, so they are copied once. The copy comes from the heap, the pool
+  // is left to packets from the network interface.
+  pbuf *buffer = packet.buffer.firstElement;
+  if (buffer->next == nullptr) {
+    pbuf_ref(buffer);
+  } else {
+    pbuf *flat = pbuf_alloc(PBUF_RAW, buffer->tot_len, PBUF_RAM);
+    if (flat == nullptr) {
+      Diagnostics::Network::lwip_allocation_failures++;
+      return false;
+    }
+    pbuf_copy(flat, buffer);
+    buffer = flat;
+  }
+  ip_addr_t src = IPADDR4_INIT((uint32_t)Config::ADDRESS);
+  // Runs on the sending writer or reader thread instead of the tcpip thread
+  m_rxCallback(m_callbackArgs, conn->pcb, buffer, &src, packet.srcPort);
+  Diagnostics::Network::udp_local_bypass_packets++;
+  return true;
+}
+
 void UdpDriver::sendPacket(PacketInfo &packet) {
+  if (deliverLocally(packet)) {
+    return;
+  }
+
   auto p_conn = createUdpConnection(packet.srcPort);
   if (p_conn == nullptr) {
     ;
@@ -285,17 +285,16 @@ void SEDPAgent::handleSubscriptionReaderMessage(
   }
   SEDP_LOG("Subscriber\n");
 #endif
+  const bool reliable =
+      readerData.reliabilityKind == ReliabilityKind_t::RELIABLE;
+  ReaderProxy proxy{readerData.endpointGuid, readerData.unicastLocator,
+                    reliable};
   if (readerData.multicastLocator.kind ==
       rtps::LocatorKind_t::LOCATOR_KIND_UDPv4) {
-    writer->addNewMatchedReader(ReaderProxy{
-        readerData.endpointGuid, readerData.unicastLocator,
-        readerData.multicastLocator,
-        (readerData.reliabilityKind == ReliabilityKind_t::RELIABLE)});
-  } else {
-    writer->addNewMatchedReader(ReaderProxy{
-        readerData.endpointGuid, readerData.unicastLocator,
-        (readerData.reliabilityKind == ReliabilityKind_t::RELIABLE)});
+    proxy.remoteMulticastLocator = readerData.multicastLocator;
   }
+  proxy.localReader = m_part->findLocalReader(readerData.endpointGuid);
+  writer->addNewMatchedReader(proxy);
 
   if (mfp_onNewSubscriberCallback != nullptr) {
     mfp_onNewSubscriberCallback(m_onNewSubscriberArgs);
@@ -307,9 +306,10 @@ void SEDPAgent::tryMatchUnmatchedEndpoints() {
   for (auto &proxy : m_unmatchedRemoteReaders) {
     auto writer = m_part->getMatchingWriter(proxy);
     if (writer != nullptr) {
-      writer->addNewMatchedReader(
-          ReaderProxy{proxy.endpointGuid, proxy.unicastLocator,
-                      proxy.multicastLocator, proxy.is_reliable});
+      ReaderProxy readerProxy{proxy.endpointGuid, proxy.unicastLocator,
+                              proxy.multicastLocator, proxy.is_reliable};
+      readerProxy.localReader = m_part->findLocalReader(proxy.endpointGuid);
+      writer->addNewMatchedReader(readerProxy);
       removeUnmatchedEntity(proxy.endpointGuid);
     }
   }
@@ -11,6 +11,7 @@
 
 #include <Arduino.h>
 
+#include "rtps/utils/Diagnostics.h"
 #include "rtps/utils/Log.h"
 #include "rtps/utils/udpUtils.h"
 
@@ -30,7 +31,8 @@
 using rtps::Domain;
 
 Domain::Domain()
-    : m_threadPool(receiveJumppad, this),
+    : m_threadPool(receiveJumppad, this, deferredWorkJumppad,
+                   deferredTransmitJumppad),
       m_transport(ThreadPool::readCallback, &m_threadPool) {
   m_transport.createUdpConnection(getUserMulticastPort());
   m_transport.createUdpConnection(getBuiltInMulticastPort());
@@ -42,6 +44,9 @@ Domain::~Domain() { stop(); }
 
 bool Domain::completeInit() {
   m_initComplete = m_threadPool.startThreads();
+  if (!m_callbackExecutor.start()) {
+    DOMAIN_LOG("Failed starting callback executor, callbacks run inline\n");
+  }
 
   if (!m_initComplete) {
     DOMAIN_LOG("Failed starting threads\n");
@@ -53,13 +58,101 @@ bool Domain::completeInit() {
   return m_initComplete;
 }
 
-void Domain::stop() { m_threadPool.stopThreads(); }
+void Domain::stop() {
+  m_threadPool.stopThreads();
+  m_callbackExecutor.stop();
+}
 
 void Domain::receiveJumppad(void *callee, const PacketInfo &packet) {
   auto domain = static_cast<Domain *>(callee);
   domain->receiveCallback(packet);
 }
 
+uint32_t Domain::deferredWorkJumppad(void *callee) {
+  auto domain = static_cast<Domain *>(callee);
+  return domain->runDeferredWork();
+}
+
+uint32_t Domain::runDeferredWork() {
+  const TickType_t now = xTaskGetTickCount();
+  TickType_t waitTicks = 0;
+  auto keepEarliest = [&waitTicks](TickType_t ticks) {
+    if (ticks != 0 && (waitTicks == 0 || ticks < waitTicks)) {
+      waitTicks = ticks;
+    }
+  };
+
+  for (auto i = 0; i < m_nextParticipantId - PARTICIPANT_START_ID; ++i) {
+    PacketInfo info;
+    TickType_t participantWaitTicks = 0;
+    while (m_participants[i].collectDueAckNacks(now, info,
+                                                participantWaitTicks)) {
+      m_transport.sendPacket(info);
+      Diagnostics::StatefulReader::sfr_acknack_messages_sent++;
+      info.buffer.destroy();
+    }
+    keepEarliest(participantWaitTicks);
+
+    m_participants[i].sendDueRepairs(now, participantWaitTicks);
+    keepEarliest(participantWaitTicks);
+  }
+
+  if (waitTicks == 0) {
+    return 0;
+  }
+  // Round up, waking up early would only lead to another round
+  return (static_cast<uint32_t>(waitTicks) * 1000 + configTICK_RATE_HZ - 1) /
+         configTICK_RATE_HZ;
+}
+
+uint32_t Domain::deferredTransmitJumppad(void *callee) {
+  auto domain = static_cast<Domain *>(callee);
+  return domain->flushTransmitAggregators();
+}
+
+void Domain::aggregatorSendJumppad(void *callee, PacketInfo &packet) {
+  auto domain = static_cast<Domain *>(callee);
+  domain->m_transport.sendPacket(packet);
+}
+
+rtps::Reader *Domain::localReaderJumppad(void *callee, const Guid_t &guid) {
+  auto domain = static_cast<Domain *>(callee);
+  return domain->findLocalReader(guid);
+}
+
+rtps::Reader *Domain::findLocalReader(const Guid_t &guid) {
+  for (auto i = 0; i < m_nextParticipantId - PARTICIPANT_START_ID; ++i) {
+    if (m_participants[i].m_guidPrefix == guid.prefix) {
+      return m_participants[i].getReader(guid.entityId);
+    }
+  }
+  return nullptr;
+}
+
+uint32_t Domain::flushTransmitAggregators() {
+  const TickType_t now = xTaskGetTickCount();
+  TickType_t waitTicks = 0;
+  auto keepEarliest = [&waitTicks](TickType_t ticks) {
+    if (ticks != 0 && (waitTicks == 0 || ticks < waitTicks)) {
+      waitTicks = ticks;
+    }
+  };
+
+  for (auto i = 0; i < m_nextParticipantId - PARTICIPANT_START_ID; ++i) {
+    keepEarliest(m_participants[i].getTransmitAggregator().flushDue(now));
+
+    TickType_t participantWaitTicks = 0;
+    m_participants[i].resumePacedWriters(now, participantWaitTicks);
+    keepEarliest(participantWaitTicks);
+  }
+
+  if (waitTicks == 0) {
+    return 0;
+  }
+  return (static_cast<uint32_t>(waitTicks) * 1000 + configTICK_RATE_HZ - 1) /
+         configTICK_RATE_HZ;
+}
+
 void Domain::receiveCallback(const PacketInfo &packet) {
   if (packet.buffer.firstElement->next != nullptr) {
 
@@ -73,7 +166,7 @@ void Domain::receiveCallback(const PacketInfo &packet) {
     for (auto i = 0; i < m_nextParticipantId - PARTICIPANT_START_ID; ++i) {
       m_participants[i].newMessage(
           static_cast<uint8_t *>(packet.buffer.firstElement->payload),
-          packet.buffer.firstElement->len);
+          packet.buffer.firstElement->len, packet.buffer.firstElement);
     }
     // First Check if UserTraffic Multicast
   } else if (isUserMultiCastPort(packet.destPort)) {
@@ -86,7 +179,7 @@ void Domain::receiveCallback(const PacketInfo &packet) {
         DOMAIN_LOG("Domain: Forward Multicast only to Participant: %u\n", i);
         m_participants[i].newMessage(
             static_cast<uint8_t *>(packet.buffer.firstElement->payload),
-            packet.buffer.firstElement->len);
+            packet.buffer.firstElement->len, packet.buffer.firstElement);
       }
     }
   } else {
@@ -100,7 +193,7 @@ void Domain::receiveCallback(const PacketInfo &packet) {
                                         // (id below START_ID)
         m_participants[id - PARTICIPANT_START_ID].newMessage(
             static_cast<uint8_t *>(packet.buffer.firstElement->payload),
-            packet.buffer.firstElement->len);
+            packet.buffer.firstElement->len, packet.buffer.firstElement);
       } else {
         DOMAIN_LOG("Domain: Participant id too high or unplausible.\n");
       }
@@ -123,6 +216,8 @@ rtps::Participant *Domain::createParticipant() {
 
   auto &entry = m_participants[nextSlot];
   entry.reuse(generateGuidPrefix(m_nextParticipantId), m_nextParticipantId);
+  entry.getTransmitAggregator().setSender(aggregatorSendJumppad, this);
+  entry.setLocalReaderLookup(localReaderJumppad, this);
   registerPort(entry);
   createBuiltinWritersAndReaders(entry);
   ++m_nextParticipantId;
@@ -319,7 +414,8 @@ rtps::Writer *Domain::writerExists(Participant &part, const char *topicName,
 
 rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
                                    const char *typeName, bool reliable,
-                                   bool enforceUnicast) {
+                                   bool enforceUnicast,
+                                   const WriterOptions &options) {
   Lock lock{m_mutex};
   StatelessWriter *statelessWriter =
       getNextUnusedEndpoint<decltype(m_statelessWriters), StatelessWriter>(
@@ -360,6 +456,13 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
 
     statefulWriter->init(attributes, TopicKind_t::NO_KEY, &m_threadPool,
                          m_transport, enforceUnicast);
+    statefulWriter->setFlowControl(options.flowControl,
+                                   &part.getUserTrafficFlowController());
+    statefulWriter->setMulticastMinReaders(options.multicastMinReaders);
+    statefulWriter->setConflation(options.conflate);
+    statefulWriter->setCompression(options.compressionThreshold);
+    statefulWriter->setDeltaEncoding(options.deltaKeyFrameInterval);
+    statefulWriter->setTransmitAggregator(&part.getTransmitAggregator());
 
     if (!part.addWriter(statefulWriter)) {
       return nullptr;
@@ -370,6 +473,12 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
 
     statelessWriter->init(attributes, TopicKind_t::NO_KEY, &m_threadPool,
                           m_transport, enforceUnicast);
+    statelessWriter->setFlowControl(options.flowControl,
+                                    &part.getUserTrafficFlowController());
+    statelessWriter->setMulticastMinReaders(options.multicastMinReaders);
+    statelessWriter->setConflation(options.conflate);
+    statelessWriter->setCompression(options.compressionThreshold);
+    statelessWriter->setTransmitAggregator(&part.getTransmitAggregator());
 
     if (!part.addWriter(statelessWriter)) {
       return nullptr;
@@ -380,7 +489,8 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
 
 rtps::Reader *Domain::createReader(Participant &part, const char *topicName,
                                    const char *typeName, bool reliable,
-                                   ip4_addr_t mcastaddress) {
+                                   ip4_addr_t mcastaddress,
+                                   const ReaderOptions &options) {
   Lock lock{m_mutex};
   StatelessReader *statelessReader =
       getNextUnusedEndpoint<decltype(m_statelessReaders), StatelessReader>(
@@ -436,6 +546,11 @@ rtps::Reader *Domain::createReader(Participant &part, const char *topicName,
     attributes.reliabilityKind = ReliabilityKind_t::RELIABLE;
 
     statefulReader->init(attributes, m_transport);
+    statefulReader->setCallbackExecutor(&m_callbackExecutor);
+    if (!statefulReader->setSampleQueue(options.sampleQueueDepth,
+                                        options.conflatePerWriter)) {
+      DOMAIN_LOG("Invalid sample queue depth.\n");
+    }
 
     if (!part.addReader(statefulReader)) {
       DOMAIN_LOG("Failed to add reader to participant.\n");
@@ -448,6 +563,11 @@ rtps::Reader *Domain::createReader(Participant &part, const char *topicName,
     attributes.reliabilityKind = ReliabilityKind_t::BEST_EFFORT;
 
     statelessReader->init(attributes);
+    statelessReader->setCallbackExecutor(&m_callbackExecutor);
+    if (!statelessReader->setSampleQueue(options.sampleQueueDepth,
+                                         options.conflatePerWriter)) {
+      DOMAIN_LOG("Invalid sample queue depth.\n");
+    }
 
     if (!part.addReader(statelessReader)) {
       return nullptr;
@@ -11,6 +11,7 @@
 
 #include "rtps/entities/Reader.h"
 #include "rtps/entities/Writer.h"
+#include "rtps/messages/MessageFactory.h"
 #include "rtps/messages/MessageReceiver.h"
 #include "rtps/utils/Lock.h"
 #include "rtps/utils/Log.h"
@@ -53,6 +54,25 @@ void Participant::reuse(const GuidPrefix_t &guidPrefix,
                         ParticipantId_t participantId) {
   m_guidPrefix = guidPrefix;
   m_participantId = participantId;
+
+  FlowControlSettings limits;
+  limits.bytesPerSecond = Config::FLOW_CONTROL_PARTICIPANT_BYTES_PER_SEC;
+  limits.packetsPerSecond = Config::FLOW_CONTROL_PARTICIPANT_PACKETS_PER_SEC;
+  setUserTrafficLimits(limits);
+  m_transmitAggregator.init(m_guidPrefix,
+                            Config::TRANSMIT_AGGREGATION_WINDOW_MS);
+}
+
+bool Participant::setUserTrafficLimits(const FlowControlSettings &settings) {
+  return m_userTrafficFlowController.init(settings);
+}
+
+rtps::FlowController &Participant::getUserTrafficFlowController() {
+  return m_userTrafficFlowController;
+}
+
+rtps::TransmitAggregator &Participant::getTransmitAggregator() {
+  return m_transmitAggregator;
 }
 
 bool Participant::isValid() {
@@ -353,6 +373,19 @@ Participant::findRemoteParticipant(const GuidPrefix_t &prefix) {
   return m_remoteParticipants.find(thunk, &isElementToFind);
 }
 
+void Participant::setLocalReaderLookup(localReaderLookup_fp lookup,
+                                       void *callee) {
+  m_localReaderLookup = lookup;
+  m_localReaderLookupCallee = callee;
+}
+
+rtps::Reader *Participant::findLocalReader(const Guid_t &guid) {
+  if (!Config::INTRA_PROCESS_DELIVERY || m_localReaderLookup == nullptr) {
+    return nullptr;
+  }
+  return m_localReaderLookup(m_localReaderLookupCallee, guid);
+}
+
 void Participant::refreshRemoteParticipantLiveliness(
     const GuidPrefix_t &prefix) {
   Lock lock{m_mutex};
@@ -369,6 +402,74 @@ void Participant::refreshRemoteParticipantLiveliness(
   }
 }
 
+bool Participant::collectDueAckNacks(TickType_t now, PacketInfo &info,
+                                     TickType_t &waitTicks) {
+  Lock lock{m_mutex};
+  waitTicks = 0;
+  LocatorIPv4 destination;
+  bool found = false;
+  for (auto reader : m_readers) {
+    if (reader == nullptr) {
+      continue;
+    }
+    TickType_t readerWaitTicks = 0;
+    if (reader->getDueAckNackDestination(now, destination, readerWaitTicks)) {
+      info.srcPort = reader->m_attributes.unicastLocator.port;
+      found = true;
+      break;
+    }
+    if (readerWaitTicks != 0 &&
+        (waitTicks == 0 || readerWaitTicks < waitTicks)) {
+      waitTicks = readerWaitTicks;
+    }
+  }
+  if (!found) {
+    return false;
+  }
+
+  info.destAddr = destination.getIp4Address();
+  info.destPort = destination.port;
+  MessageFactory::addHeader(info.buffer, m_guidPrefix);
+  for (auto reader : m_readers) {
+    if (reader != nullptr) {
+      reader->appendDueAckNacks(now, destination, info.buffer);
+    }
+  }
+  return true;
+}
+
+void Participant::sendDueRepairs(TickType_t now, TickType_t &waitTicks) {
+  Lock lock{m_mutex};
+  waitTicks = 0;
+  for (auto writer : m_writers) {
+    if (writer == nullptr) {
+      continue;
+    }
+    TickType_t writerWaitTicks = 0;
+    writer->sendDueRepairs(now, writerWaitTicks);
+    if (writerWaitTicks != 0 &&
+        (waitTicks == 0 || writerWaitTicks < waitTicks)) {
+      waitTicks = writerWaitTicks;
+    }
+  }
+}
+
+void Participant::resumePacedWriters(TickType_t now, TickType_t &waitTicks) {
+  Lock lock{m_mutex};
+  waitTicks = 0;
+  for (auto writer : m_writers) {
+    if (writer == nullptr) {
+      continue;
+    }
+    TickType_t writerWaitTicks = 0;
+    writer->resumePaced(now, writerWaitTicks);
+    if (writerWaitTicks != 0 &&
+        (waitTicks == 0 || writerWaitTicks < waitTicks)) {
+      waitTicks = writerWaitTicks;
+    }
+  }
+}
+
 bool Participant::hasReaderWithMulticastLocator(const IPAddress& address) {
   Lock lock{m_mutex};
   for (uint8_t i = 0; i < m_readers.size(); i++) {
@@ -523,8 +624,9 @@ void Participant::addBuiltInEndpoints(BuiltInEndpoints &endpoints) {
   addReader(endpoints.sedpSubReader);
 }
 
-void Participant::newMessage(const uint8_t *data, DataSize_t size) {
-  if (!m_receiver.processMessage(data, size)) {
+void Participant::newMessage(const uint8_t *data, DataSize_t size,
+                             pbuf *buffer) {
+  if (!m_receiver.processMessage(data, size, buffer)) {
     PARTICIPANT_LOG("MESSAGE PROCESSING FAILE \r\n");
   }
 }
@@ -9,24 +9,217 @@
 
 #include <rtps/entities/Reader.h>
 
+#include <rtps/CallbackExecutor.h>
 #include <rtps/entities/StatefulReader.h>
 #include <rtps/entities/StatelessReader.h>
+#include <rtps/messages/Encapsulation.h>
+#include <rtps/messages/MessageTypes.h>
+#include <rtps/utils/Diagnostics.h>
 #include <rtps/utils/Lock.h>
 #include <rtps/utils/Log.h>
+#include <rtps/utils/Lz4.h>
+#include <rtps/utils/XorDelta.h>
+#include <rtps/utils/sysFunctions.h>
 
 using namespace rtps;
 
-Reader::Reader() { m_callbacks.fill({nullptr, nullptr, 0}); }
+namespace {
+
+// Returns a contiguous pbuf with the plain payload or a nullptr
+pbuf *decompressPayload(const uint8_t *data, DataSize_t size) {
+  const uint32_t bodySize = data[4] | (data[5] << 8) |
+                            (static_cast<uint32_t>(data[6]) << 16) |
+                            (static_cast<uint32_t>(data[7]) << 24);
+  if (bodySize > UINT16_MAX - Encapsulation::HEADER_SIZE) {
+    return nullptr;
+  }
+
+  const uint32_t start = getMicroseconds();
+  pbuf *plain = pbuf_alloc(
+      PBUF_RAW, static_cast<DataSize_t>(Encapsulation::HEADER_SIZE + bodySize),
+      PBUF_RAM);
+  if (plain == nullptr) {
+    return nullptr;
+  }
+  auto *out = static_cast<uint8_t *>(plain->payload);
+  memcpy(out, data, Encapsulation::HEADER_SIZE);
+  out[2] &= ~Encapsulation::OPTION_COMPRESSED;
+  if (Lz4::decompress(data + Encapsulation::COMPRESSED_HEADER_SIZE,
+                      size - Encapsulation::COMPRESSED_HEADER_SIZE,
+                      out + Encapsulation::HEADER_SIZE,
+                      bodySize) != bodySize) {
+    pbuf_free(plain);
+    return nullptr;
+  }
+  Diagnostics::Compression::decompressed_samples++;
+  Diagnostics::Compression::decompression_time_us += getMicroseconds() - start;
+  return plain;
+}
+
+uint32_t readUInt32(const uint8_t *data) {
+  return data[0] | (data[1] << 8) | (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Restores the plain payload from a key frame or a delta to the base kept
+// in proxy, which then becomes the new base. Returns a nullptr if the base
+// is not the one the delta refers to.
+pbuf *decodeDelta(const ReaderCacheChange &change, WriterProxy *proxy) {
+  const uint8_t *data = change.getData();
+  const uint32_t bodySize = readUInt32(data + 4);
+  SequenceNumber_t baseSN;
+  baseSN.high = static_cast<int32_t>(readUInt32(data + 8));
+  baseSN.low = readUInt32(data + 12);
+  const uint8_t *encoded = data + Encapsulation::DELTA_HEADER_SIZE;
+  const uint32_t encodedSize = change.size - Encapsulation::DELTA_HEADER_SIZE;
+  const uint32_t size = Encapsulation::HEADER_SIZE + bodySize;
+
+  const bool isKeyFrame = baseSN == SequenceNumber_t{0, 0};
+  if (size > UINT16_MAX || (isKeyFrame && encodedSize != bodySize)) {
+    return nullptr;
+  }
+  if (!isKeyFrame &&
+      (proxy == nullptr || proxy->deltaBase == nullptr ||
+       proxy->deltaBaseSN != baseSN || proxy->deltaBase->tot_len != size)) {
+    return nullptr;
+  }
+
+  pbuf *plain =
+      pbuf_alloc(PBUF_RAW, static_cast<DataSize_t>(size), PBUF_RAM);
+  if (plain == nullptr) {
+    return nullptr;
+  }
+  auto *out = static_cast<uint8_t *>(plain->payload);
+  memcpy(out, data, Encapsulation::HEADER_SIZE);
+  out[2] &= ~Encapsulation::OPTION_DELTA;
+  if (isKeyFrame) {
+    memcpy(out + Encapsulation::HEADER_SIZE, encoded, bodySize);
+  } else if (!XorDelta::decode(static_cast<const uint8_t *>(
+                                   proxy->deltaBase->payload) +
+                                   Encapsulation::HEADER_SIZE,
+                               encoded, encodedSize,
+                               out + Encapsulation::HEADER_SIZE, bodySize)) {
+    pbuf_free(plain);
+    return nullptr;
+  }
+
+  if (proxy != nullptr) {
+    pbuf_ref(plain);
+    if (proxy->deltaBase != nullptr) {
+      pbuf_free(proxy->deltaBase);
+    }
+    proxy->deltaBase = plain;
+    proxy->deltaBaseSN = change.sn;
+  }
+  return plain;
+}
+
+} // namespace
+
+Reader::Reader() {
+  m_callbacks.fill({nullptr, nullptr, 0, CallbackMode::INLINE});
+}
+
+void Reader::executeCallbacks(const ReaderCacheChange &cacheChange,
+                              WriterProxy *proxy) {
+  pbuf *plain = nullptr;
+  if (Encapsulation::isCompressed(cacheChange.getData(), cacheChange.size)) {
+    // Decompressed once for all callbacks, retained samples keep the pbuf
+    plain = decompressPayload(cacheChange.getData(), cacheChange.size);
+    if (plain == nullptr) {
+      Diagnostics::Compression::decompression_failures++;
+      return;
+    }
+  } else if (Encapsulation::isDelta(cacheChange.getData(),
+                                    cacheChange.size)) {
+    plain = decodeDelta(cacheChange, proxy);
+    if (plain == nullptr) {
+      Diagnostics::StatefulReader::sfr_delta_samples_dropped++;
+      return;
+    }
+  } else {
+    dispatchSample(cacheChange);
+    return;
+  }
+
+  const ReaderCacheChange change{cacheChange.kind,
+                                 cacheChange.writerGuid,
+                                 cacheChange.sn,
+                                 static_cast<const uint8_t *>(plain->payload),
+                                 plain->tot_len,
+                                 plain};
+  // A decompressed payload might still be delta encoded
+  executeCallbacks(change, proxy);
+  pbuf_free(plain);
+}
+
+void Reader::dispatchSample(const ReaderCacheChange &cacheChange) {
+  if (m_sampleQueue.isEnabled()) {
+    // The application takes it from its own thread
+    m_sampleQueue.push(cacheChange.retain());
+    return;
+  }
 
-void Reader::executeCallbacks(const ReaderCacheChange &cacheChange) {
   Lock lock{m_callback_mutex};
+  const bool canDefer =
+      mp_callbackExecutor != nullptr && mp_callbackExecutor->isRunning();
   for (unsigned int i = 0; i < m_callbacks.size(); i++) {
-    if (m_callbacks[i].function != nullptr) {
+    if (m_callbacks[i].function == nullptr) {
+      continue;
+    }
+    if (canDefer && m_callbacks[i].mode == CallbackMode::DEFERRED) {
+      mp_callbackExecutor->dispatch(*this, m_callbacks[i].identifier,
+                                    cacheChange);
+    } else {
       m_callbacks[i].function(m_callbacks[i].arg, cacheChange);
     }
   }
 }
 
+void Reader::executeDeferredCallback(callbackIdentifier_t identifier,
+                                     const ReaderCacheChange &cacheChange) {
+  callbackFunction_t function = nullptr;
+  void *arg = nullptr;
+  {
+    // Not held during the callback, the receive thread would block on it
+    Lock lock{m_callback_mutex};
+    for (const auto &callback : m_callbacks) {
+      if (callback.function != nullptr && callback.identifier == identifier) {
+        function = callback.function;
+        arg = callback.arg;
+        break;
+      }
+    }
+  }
+  if (function != nullptr) {
+    function(arg, cacheChange);
+  }
+}
+
+void Reader::setCallbackExecutor(CallbackExecutor *executor) {
+  Lock lock{m_callback_mutex};
+  mp_callbackExecutor = executor;
+}
+
+bool Reader::setSampleQueue(uint8_t depth, bool conflatePerWriter) {
+  return m_sampleQueue.init(depth, conflatePerWriter);
+}
+
+bool Reader::takeSample(SampleHandle &sample, uint32_t timeoutMs) {
+  return m_sampleQueue.take(sample, timeoutMs);
+}
+
+uint8_t Reader::take(SampleHandle *samples, uint8_t maxSamples,
+                     uint32_t timeoutMs) {
+  return m_sampleQueue.take(samples, maxSamples, timeoutMs);
+}
+
+uint8_t Reader::read(SampleHandle *samples, uint8_t maxSamples) {
+  return m_sampleQueue.read(samples, maxSamples);
+}
+
+bool Reader::hasSamples() { return m_sampleQueue.hasSamples(); }
+
 bool Reader::initMutex() {
   if (m_proxies_mutex == nullptr) {
     if (!createMutex(&m_proxies_mutex)) {
@@ -49,16 +242,67 @@ void Reader::reset() {
   Lock lock1{m_proxies_mutex};
   Lock lock2{m_callback_mutex};
 
-  m_proxies.clear();
+  clearProxies();
   for (unsigned int i = 0; i < m_callbacks.size(); i++) {
     m_callbacks[i].function = nullptr;
     m_callbacks[i].arg = nullptr;
   }
 
   m_callback_count = 0;
+  m_sampleQueue.init(0, false);
   m_is_initialized_ = false;
 }
 
+void Reader::clearProxies() {
+  for (auto &proxy : m_proxies) {
+    proxy.releaseSamples();
+  }
+  m_proxies.clear();
+  m_fragments.clear();
+}
+
+void Reader::newFragments(const SubmessageDataFrag &msg,
+                          const GuidPrefix_t &remotePrefix,
+                          const uint8_t *data, DataSize_t size) {
+  if (!m_is_initialized_) {
+    return;
+  }
+
+  const Guid_t writerGuid{remotePrefix, msg.writerId};
+  pbuf *sample = nullptr;
+  {
+    Lock lock{m_proxies_mutex};
+    if (!isFragmentRelevant(writerGuid, msg.writerSN)) {
+      return;
+    }
+    sample = m_fragments.addFragments(
+        writerGuid, msg.writerSN, msg.sampleSize, msg.fragmentSize,
+        msg.fragmentStartingNum.value, msg.fragmentsInSubmessage, data, size);
+  }
+  if (sample == nullptr) {
+    return;
+  }
+
+  ReaderCacheChange change{ChangeKind_t::ALIVE,
+                           writerGuid,
+                           msg.writerSN,
+                           static_cast<const uint8_t *>(sample->payload),
+                           static_cast<DataSize_t>(msg.sampleSize),
+                           sample};
+  newChange(change);
+  pbuf_free(sample);
+}
+
+bool Reader::onNewHeartbeatFrag(const SubmessageHeartbeatFrag & /*msg*/,
+                                const GuidPrefix_t & /*remotePrefix*/) {
+  return true;
+}
+
+bool Reader::isFragmentRelevant(const Guid_t & /*writerGuid*/,
+                                const SequenceNumber_t & /*sn*/) {
+  return true;
+}
+
 bool Reader::isProxy(const Guid_t &guid) {
   for (const auto &proxy : m_proxies) {
     if (proxy.remoteWriterGuid.operator==(guid)) {
@@ -79,7 +323,8 @@ WriterProxy *Reader::getProxy(Guid_t guid) {
 }
 
 Reader::callbackIdentifier_t
-Reader::registerCallback(Reader::callbackFunction_t cb, void *arg) {
+Reader::registerCallback(Reader::callbackFunction_t cb, void *arg,
+                         CallbackMode mode) {
   Lock lock{m_callback_mutex};
   if (m_callback_count == m_callbacks.size() || cb == nullptr) {
     return false;
@@ -90,6 +335,7 @@ Reader::registerCallback(Reader::callbackFunction_t cb, void *arg) {
       m_callbacks[i].function = cb;
       m_callbacks[i].arg = arg;
       m_callbacks[i].identifier = m_callback_identifier++;
+      m_callbacks[i].mode = mode;
       m_callback_count++;
       return m_callbacks[i].identifier;
     }
@@ -121,6 +367,12 @@ void Reader::removeAllProxiesOfParticipant(const GuidPrefix_t &guidPrefix) {
   auto isElementToRemove = [&](const WriterProxy &proxy) {
     return proxy.remoteWriterGuid.prefix == guidPrefix;
   };
+  for (auto &proxy : m_proxies) {
+    if (isElementToRemove(proxy)) {
+      proxy.releaseSamples();
+    }
+  }
+  m_fragments.removeAllOfParticipant(guidPrefix);
   auto thunk = [](void *arg, const WriterProxy &value) {
     return (*static_cast<decltype(isElementToRemove) *>(arg))(value);
   };
@@ -133,6 +385,12 @@ bool Reader::removeProxy(const Guid_t &guid) {
   auto isElementToRemove = [&](const WriterProxy &proxy) {
     return proxy.remoteWriterGuid == guid;
   };
+  for (auto &proxy : m_proxies) {
+    if (isElementToRemove(proxy)) {
+      proxy.releaseSamples();
+    }
+  }
+  m_fragments.remove(guid);
   auto thunk = [](void *arg, const WriterProxy &value) {
     return (*static_cast<decltype(isElementToRemove) *>(arg))(value);
   };
@@ -172,3 +430,14 @@ int rtps::Reader::dumpAllProxies(dumpProxyCallback target, void *arg) {
 bool rtps::Reader::sendPreemptiveAckNack(const WriterProxy &writer) {
   return true;
 }
+
+bool rtps::Reader::getDueAckNackDestination(TickType_t /*now*/,
+                                            LocatorIPv4 & /*destination*/,
+                                            TickType_t &waitTicks) {
+  waitTicks = 0;
+  return false;
+}
+
+void rtps::Reader::appendDueAckNacks(TickType_t /*now*/,
+                                     const LocatorIPv4 & /*destination*/,
+                                     PBufWrapper & /*buffer*/) {}
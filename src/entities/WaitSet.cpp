@@ -0,0 +1,104 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/entities/WaitSet.h"
+
+#include "rtps/entities/Reader.h"
+
+using rtps::WaitSet;
+
+WaitSet::~WaitSet() {
+  if (sys_sem_valid(&m_signal)) {
+    sys_sem_free(&m_signal);
+  }
+}
+
+bool WaitSet::init() {
+  if (m_mutex == nullptr && !createMutex(&m_mutex)) {
+    return false;
+  }
+  if (!sys_sem_valid(&m_signal) && sys_sem_new(&m_signal, 0) != ERR_OK) {
+    return false;
+  }
+  return true;
+}
+
+bool WaitSet::attach(Reader &reader) {
+  if (!init()) {
+    return false;
+  }
+
+  Lock lock{m_mutex};
+  Reader **unused = nullptr;
+  for (auto &attached : m_readers) {
+    if (attached == &reader) {
+      return true;
+    }
+    if (attached == nullptr && unused == nullptr) {
+      unused = &attached;
+    }
+  }
+  if (unused == nullptr || !reader.m_sampleQueue.setListener(&m_signal)) {
+    return false;
+  }
+  *unused = &reader;
+  return true;
+}
+
+bool WaitSet::detach(Reader &reader) {
+  if (m_mutex == nullptr) {
+    return false;
+  }
+
+  Lock lock{m_mutex};
+  for (auto &attached : m_readers) {
+    if (attached == &reader) {
+      reader.m_sampleQueue.setListener(nullptr);
+      attached = nullptr;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t WaitSet::collectReady(Reader **ready, uint8_t maxReady) {
+  Lock lock{m_mutex};
+  uint8_t numReady = 0;
+  for (auto *reader : m_readers) {
+    if (reader == nullptr || !reader->hasSamples()) {
+      continue;
+    }
+    if (ready != nullptr && numReady < maxReady) {
+      ready[numReady] = reader;
+    }
+    ++numReady;
+  }
+  return numReady;
+}
+
+uint8_t WaitSet::wait(Reader **ready, uint8_t maxReady, uint32_t timeoutMs) {
+  if (m_mutex == nullptr) {
+    return 0;
+  }
+
+  while (true) {
+    const uint8_t numReady = collectReady(ready, maxReady);
+    if (numReady != 0 || timeoutMs == 0) {
+      return numReady;
+    }
+    // Signals of samples that were taken in the meantime wake us up early,
+    // wait again for what is left of the timeout
+    const uint32_t waited = sys_arch_sem_wait(&m_signal, timeoutMs);
+    if (waited == SYS_ARCH_TIMEOUT || waited >= timeoutMs) {
+      timeoutMs = 0;
+    } else {
+      timeoutMs -= waited;
+    }
+  }
+}
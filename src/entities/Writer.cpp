@@ -9,8 +9,16 @@
 
 #include <rtps/entities/Writer.h>
 
+#include "rtps/messages/Encapsulation.h"
+#include "rtps/messages/MessageFactory.h"
+#include "rtps/messages/MessageTypes.h"
+#include "rtps/utils/Diagnostics.h"
 #include "rtps/utils/Log.h"
+#include "rtps/utils/Lz4.h"
+#include "rtps/utils/sysFunctions.h"
+#include <algorithm>
 #include <rtps/config.h>
+#include <rtps/entities/Reader.h>
 #include <rtps/entities/ReaderProxy.h>
 #include <rtps/entities/StatefulWriter.h>
 #include <rtps/storages/MemoryPool.h>
@@ -26,8 +34,14 @@ bool rtps::Writer::addNewMatchedReader(const ReaderProxy &newProxy) {
 #endif
   Lock lock{m_mutex};
   bool success = m_proxies.add(newProxy);
-  if (!m_enforceUnicast) {
-    manageSendOptions();
+  // Local readers get DATA directly, they never take part in multicast
+  if (success && !m_enforceUnicast && newProxy.localReader == nullptr) {
+    for (auto &proxy : m_proxies) {
+      if (proxy.remoteReaderGuid == newProxy.remoteReaderGuid) {
+        m_multicastGroups.add(proxy);
+        break;
+      }
+    }
   }
   return success;
 }
@@ -42,9 +56,8 @@ bool rtps::Writer::removeProxy(const Guid_t &guid) {
     return (*static_cast<decltype(isElementToRemove) *>(arg))(value);
   };
 
-  bool ret = m_proxies.remove(thunk, &isElementToRemove);
-  resetSendOptions();
-  return ret;
+  removeFromMulticastGroups(thunk, &isElementToRemove);
+  return m_proxies.remove(thunk, &isElementToRemove);
 }
 
 uint32_t rtps::Writer::getProxiesCount() {
@@ -52,14 +65,106 @@ uint32_t rtps::Writer::getProxiesCount() {
   return m_proxies.getNumElements();
 }
 
-void rtps::Writer::resetSendOptions() {
-  INIT_GUARD()
+void rtps::Writer::removeFromMulticastGroups(
+    bool (*jumppad)(void *, const ReaderProxy &), void *isElementToRemove) {
   for (auto &proxy : m_proxies) {
-    proxy.suppressUnicast = false;
-    proxy.useMulticast = false;
-    proxy.unknown_eid = false;
+    if (jumppad(isElementToRemove, proxy)) {
+      m_multicastGroups.remove(proxy);
+    }
   }
-  manageSendOptions();
+}
+
+void rtps::Writer::setMulticastMinReaders(uint8_t minReaders) {
+  Lock lock{m_mutex};
+  m_multicastGroups.setMinReaders(minReaders);
+}
+
+void rtps::Writer::setConflation(bool enable) {
+  Lock lock{m_mutex};
+  m_conflate = enable;
+}
+
+void rtps::Writer::setCompression(DataSize_t threshold) {
+  Lock lock{m_mutex};
+  m_compressionThreshold = threshold;
+}
+
+rtps::CompressionStats rtps::Writer::getCompressionStats() {
+  Lock lock{m_mutex};
+  return m_compressionStats;
+}
+
+void rtps::Writer::compressPayload(CacheChange &change) {
+  if (m_compressionThreshold == 0 || change.hasInlinePayload() ||
+      !change.data.isValid()) {
+    return;
+  }
+  const pbuf *first = change.data.firstElement;
+  const DataSize_t size = first->tot_len;
+  if (size < m_compressionThreshold ||
+      size <= Encapsulation::COMPRESSED_HEADER_SIZE) {
+    return;
+  }
+
+  const uint32_t start = getMicroseconds();
+  // The codec needs contiguous input. Payloads beyond a slab element come
+  // from the pbuf pool and are chained, they are compressed from a copy.
+  PBufWrapper flat;
+  if (first->len != size) {
+    flat = PBufWrapper{pbuf_alloc(PBUF_RAW, size, PBUF_RAM)};
+    if (!flat.isValid()) {
+      return;
+    }
+    pbuf_copy_partial(first, flat.firstElement->payload, size, 0);
+    first = flat.firstElement;
+  }
+  const auto *data = static_cast<const uint8_t *>(first->payload);
+  ucdrEndianness endianness;
+  if (!Encapsulation::readHeader(data, size, endianness) ||
+      Encapsulation::isCompressed(data, size)) {
+    return;
+  }
+
+  PBufWrapper compressed{pbuf_alloc(PBUF_TRANSPORT, size, PBUF_RAM)};
+  if (!compressed.isValid()) {
+    return;
+  }
+  auto *out = static_cast<uint8_t *>(compressed.firstElement->payload);
+  const DataSize_t bodySize = size - Encapsulation::HEADER_SIZE;
+  // Capacity below the input size, results that save nothing are dropped
+  const uint32_t compressedSize = Lz4::compress(
+      data + Encapsulation::HEADER_SIZE, bodySize,
+      out + Encapsulation::COMPRESSED_HEADER_SIZE,
+      size - Encapsulation::COMPRESSED_HEADER_SIZE - 1);
+  const uint32_t elapsed = getMicroseconds() - start;
+
+  DataSize_t saved = 0;
+  if (compressedSize != 0) {
+    memcpy(out, data, Encapsulation::HEADER_SIZE);
+    out[2] |= Encapsulation::OPTION_COMPRESSED;
+    out[4] = static_cast<uint8_t>(bodySize & 0xFF);
+    out[5] = static_cast<uint8_t>(bodySize >> 8);
+    out[6] = 0;
+    out[7] = 0;
+    const DataSize_t newSize =
+        Encapsulation::COMPRESSED_HEADER_SIZE + compressedSize;
+    // Shrinks in place, memory of PBUF_RAM is contiguous
+    pbuf_realloc(compressed.firstElement, newSize);
+    change.data = std::move(compressed);
+    saved = size - newSize;
+  }
+
+  Lock lock{m_mutex};
+  if (saved != 0) {
+    m_compressionStats.compressedSamples++;
+    m_compressionStats.bytesSaved += saved;
+    Diagnostics::Compression::compressed_samples++;
+    Diagnostics::Compression::compression_bytes_saved += saved;
+  } else {
+    m_compressionStats.incompressibleSamples++;
+  }
+  m_compressionStats.timeUs += elapsed;
+  Diagnostics::Compression::compression_time_us += elapsed;
 }
 
 const rtps::CacheChange *rtps::Writer::newChange(ChangeKind_t kind,
@@ -68,42 +173,55 @@ const rtps::CacheChange *rtps::Writer::newChange(ChangeKind_t kind,
   return newChange(kind, data, size, false, false);
 }
 
-void rtps::Writer::manageSendOptions() {
+uint32_t rtps::Writer::newChanges(const Sample *samples,
+                                  uint32_t numSamples) {
   INIT_GUARD();
-  Lock lock{m_mutex};
-  for (auto &proxy : m_proxies) {
-    if (proxy.remoteMulticastLocator.kind ==
-        LocatorKind_t::LOCATOR_KIND_INVALID) {
-      proxy.suppressUnicast = false;
-      proxy.useMulticast = false;
-    } else {
-      bool found = false;
-      for (auto &avproxy : m_proxies) {
-        if (avproxy.remoteMulticastLocator.kind ==
-                LocatorKind_t::LOCATOR_KIND_UDPv4 &&
-            avproxy.remoteMulticastLocator.getIp4Address() ==
-                proxy.remoteMulticastLocator.getIp4Address() &&
-            avproxy.remoteLocator.getIp4Address() !=
-                proxy.remoteLocator.getIp4Address()) {
-          if (avproxy.suppressUnicast == false) {
-            avproxy.useMulticast = false;
-            avproxy.suppressUnicast = true;
-            proxy.useMulticast = true;
-            proxy.suppressUnicast = true;
-            if (avproxy.remoteReaderGuid.entityId !=
-                proxy.remoteReaderGuid.entityId) {
-              proxy.unknown_eid = true;
-            }
-          }
-          found = true;
-        }
-      }
-      if (!found) {
-        proxy.useMulticast = false;
-        proxy.suppressUnicast = false;
-      }
+  if (samples == nullptr) {
+    return 0;
+  }
+
+  // The mutex is not held across the batch, newChange compresses before
+  // taking it. Changes added while the flag is set are drained by the
+  // workload scheduled below.
+  {
+    Lock lock{m_mutex};
+    m_batchInsert = true;
+  }
+  uint32_t numAdded = 0;
+  for (uint32_t i = 0; i < numSamples; ++i) {
+    if (newChange(samples[i].kind, samples[i].data, samples[i].size, false,
+                  false) != nullptr) {
+      ++numAdded;
     }
   }
+  {
+    Lock lock{m_mutex};
+    m_batchInsert = false;
+  }
+
+  if (numAdded != 0 && mp_threadPool != nullptr) {
+    mp_threadPool->addWorkload(this);
+  }
+  return numAdded;
+}
+
+rtps::LoanedSample rtps::Writer::loanSample(DataSize_t size) {
+  return LoanedSample{size};
+}
+
+const rtps::CacheChange *rtps::Writer::commitLoan(LoanedSample &&sample,
+                                                  DataSize_t size,
+                                                  ChangeKind_t kind) {
+  LoanedSample loan = std::move(sample);
+  if (!loan.isValid() || size > loan.capacity()) {
+    return nullptr;
+  }
+
+  // Shrinks in place, memory of PBUF_RAM is contiguous
+  pbuf_realloc(loan.m_buffer.firstElement, size);
+  CacheChange change;
+  change.data = std::move(loan.m_buffer);
+  return addChangeToHistory(kind, std::move(change), false, false);
 }
 
 void rtps::Writer::removeAllProxiesOfParticipant(
@@ -117,8 +235,12 @@ void rtps::Writer::removeAllProxiesOfParticipant(
     return (*static_cast<decltype(isElementToRemove) *>(arg))(value);
   };
 
+  removeFromMulticastGroups(thunk, &isElementToRemove);
   m_proxies.remove(thunk, &isElementToRemove);
-  resetSendOptions();
+}
+
+rtps::PBufPool rtps::Writer::getTransmitPool() {
+  return isBuiltinEndpoint() ? PBufPool::META_TX : PBufPool::USER_TX;
 }
 
 bool rtps::Writer::isBuiltinEndpoint() {
@@ -135,6 +257,244 @@ bool rtps::Writer::isIrrelevant(ChangeKind_t kind) const {
   return kind != ChangeKind_t::ALIVE;
 }
 
+bool rtps::Writer::setFlowControl(const FlowControlSettings &settings,
+                                  FlowController *participantController) {
+  Lock lock{m_mutex};
+  mp_participantFlowController = participantController;
+  return m_flowController.init(settings);
+}
+
+bool rtps::Writer::paceTransmission(uint32_t bytes, uint32_t packets,
+                                    bool deferrable) {
+  if (isBuiltinEndpoint()) {
+    // Metatraffic bypasses pacing, discovery must never be held back
+    return true;
+  }
+
+  if (deferrable) {
+    Lock lock{m_mutex};
+    if (m_isPaced) {
+      // Scheduled by a new sample while still waiting for the budget
+      return false;
+    }
+    if (m_pacingReserved) {
+      // Paid for before the writer was deferred
+      m_pacingReserved = false;
+      return true;
+    }
+  }
+
+  uint32_t delay = m_flowController.reserve(bytes, packets);
+  if (mp_participantFlowController != nullptr) {
+    delay =
+        std::max(delay, mp_participantFlowController->reserve(bytes, packets));
+  }
+
+  if (delay == 0 || !deferrable) {
+    return true;
+  }
+
+  Diagnostics::FlowControl::paced_transmissions++;
+  Diagnostics::FlowControl::pacing_delay_ms += delay;
+  Lock lock{m_mutex};
+  m_isPaced = true;
+  m_pacingReserved = true;
+  m_pacedSince = xTaskGetTickCount();
+  // At least one tick, otherwise the writer would be resumed right away
+  m_pacingTicks = std::max<TickType_t>(pdMS_TO_TICKS(delay), 1);
+  return false;
+}
+
+void rtps::Writer::resumePaced(TickType_t now, TickType_t &waitTicks) {
+  waitTicks = 0;
+  {
+    Lock lock{m_mutex};
+    if (!m_isPaced) {
+      return;
+    }
+    const TickType_t elapsed = now - m_pacedSince;
+    if (elapsed < m_pacingTicks) {
+      waitTicks = m_pacingTicks - elapsed;
+      return;
+    }
+    m_isPaced = false;
+  }
+
+  if (mp_threadPool != nullptr) {
+    mp_threadPool->addWorkload(this);
+  }
+}
+
+void rtps::Writer::sendDueRepairs(TickType_t /*now*/, TickType_t &waitTicks) {
+  waitTicks = 0;
+}
+
+void rtps::Writer::onNewNackFrag(const SubmessageNackFrag & /*msg*/,
+                                 const GuidPrefix_t & /*sourceGuidPrefix*/) {}
+
+void rtps::Writer::setTransmitAggregator(TransmitAggregator *aggregator) {
+  Lock lock{m_mutex};
+  mp_transmitAggregator = aggregator;
+}
+
+bool rtps::Writer::aggregateData(const LocatorIPv4 &destination,
+                                 const CacheChange &change,
+                                 const EntityId_t &readerId) {
+  if (mp_transmitAggregator == nullptr || isBuiltinEndpoint() ||
+      needsFragmentation(change)) {
+    return false;
+  }
+
+  const DataSize_t size =
+      SubmessageData::getRawSize() + change.getDataSize();
+  return mp_transmitAggregator->add(
+      destination, m_srcPort, size, [&](PBufWrapper &buffer) {
+        // Copied, the message is extended behind the payload later on
+        MessageFactory::addSubMessageData(buffer, change,
+                                          m_attributes.endpointGuid.entityId,
+                                          readerId, true);
+      });
+}
+
+void rtps::Writer::flushAggregatedData(const LocatorIPv4 &destination) {
+  if (mp_transmitAggregator == nullptr || isBuiltinEndpoint()) {
+    return;
+  }
+  mp_transmitAggregator->flush(destination, m_srcPort);
+}
+
+void rtps::Writer::addLocalDelivery(LocalDelivery &delivery,
+                                    const ReaderProxy &proxy,
+                                    const CacheChange &change) {
+  if (delivery.numReaders == delivery.readers.size()) {
+    return;
+  }
+
+  if (delivery.numReaders == 0) {
+    const DataSize_t size = change.getDataSize();
+    pbuf *buffer = nullptr;
+    if (!change.hasInlinePayload() && change.data.isValid() &&
+        change.data.firstElement->len == size) {
+      // Shared with the history, readers retaining it just take a reference
+      buffer = change.data.firstElement;
+      pbuf_ref(buffer);
+    } else if (size != 0) {
+      // Inline or chained, readers expect a contiguous pbuf
+      buffer = pbuf_alloc(PBUF_RAW, size, PBUF_RAM);
+      if (buffer == nullptr) {
+        Diagnostics::Network::lwip_allocation_failures++;
+        return;
+      }
+      if (change.hasInlinePayload()) {
+        memcpy(buffer->payload, change.inlinePayload.data(), size);
+      } else {
+        pbuf_copy_partial(change.data.firstElement, buffer->payload, size, 0);
+      }
+    }
+    delivery.kind = change.kind;
+    delivery.sequenceNumber = change.sequenceNumber;
+    delivery.buffer = buffer;
+    delivery.size = size;
+  }
+
+  delivery.readers[delivery.numReaders] = proxy.localReader;
+  delivery.readerGuids[delivery.numReaders] = proxy.remoteReaderGuid;
+  ++delivery.numReaders;
+}
+
+void rtps::Writer::deliverLocally(LocalDelivery &delivery) {
+  const auto *data =
+      delivery.buffer != nullptr
+          ? static_cast<const uint8_t *>(delivery.buffer->payload)
+          : nullptr;
+  const ReaderCacheChange sample{delivery.kind, m_attributes.endpointGuid,
+                                 delivery.sequenceNumber, data, delivery.size,
+                                 delivery.buffer};
+  for (uint8_t i = 0; i < delivery.numReaders; ++i) {
+    // Endpoints live as long as the Domain, but the slot might have been
+    // reused before the deletion of the reader was announced
+    Reader &reader = *delivery.readers[i];
+    if (!reader.isInitialized() ||
+        !(reader.m_attributes.endpointGuid == delivery.readerGuids[i])) {
+      continue;
+    }
+    reader.newChange(sample);
+    Diagnostics::Network::intra_process_samples++;
+  }
+
+  if (delivery.buffer != nullptr) {
+    pbuf_free(delivery.buffer);
+    delivery.buffer = nullptr;
+  }
+  delivery.numReaders = 0;
+}
+
+bool rtps::Writer::needsFragmentation(const CacheChange &change) {
+  return change.kind == ChangeKind_t::ALIVE && !change.hasInlinePayload() &&
+         change.getDataSize() > Config::DATA_FRAG_SIZE;
+}
+
+uint32_t rtps::Writer::sendFragments(const LocatorIPv4 &destination,
+                                     const EntityId_t &readerId,
+                                     const CacheChange &change,
+                                     const FragmentNumberSet *requested,
+                                     bool announce) {
+  uint32_t bytesSent = 0;
+  PacketInfo info;
+  auto flush = [&]() {
+    if (!info.buffer.isValid()) {
+      return;
+    }
+    bytesSent += info.buffer.spaceUsed();
+    sendPacket(info);
+    info.buffer.destroy();
+  };
+  auto reserve = [&](DataSize_t size) {
+    if (info.buffer.isValid() &&
+        info.buffer.spaceUsed() + size > Config::MAX_RTPS_MESSAGE_SIZE) {
+      flush();
+    }
+    if (!info.buffer.isValid()) {
+      info.buffer.setPool(getTransmitPool());
+      info.srcPort = m_srcPort;
+      info.destAddr = destination.getIp4Address();
+      info.destPort = static_cast<Ip4Port_t>(destination.port);
+      MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
+      MessageFactory::addSubMessageTimeStamp(info.buffer);
+    }
+  };
+
+  const uint32_t numFragments =
+      MessageFactory::getNumFragments(change.getDataSize());
+  for (uint32_t fragment = 1; fragment <= numFragments; ++fragment) {
+    if (requested != nullptr && !requested->contains(fragment)) {
+      continue;
+    }
+    reserve(SubmessageDataFrag::getRawSize() +
+            MessageFactory::getFragmentSize(change.getDataSize(), fragment));
+    if (!MessageFactory::addSubMessageDataFrag(
+            info.buffer, change, fragment, m_attributes.endpointGuid.entityId,
+            readerId)) {
+      SFW_LOG("Failed to add fragment %u\n", fragment);
+    }
+  }
+
+  if (announce) {
+    reserve(SubmessageHeartbeatFrag::getRawSize());
+    ++m_hbFragCount.value;
+    MessageFactory::addHeartbeatFrag(
+        info.buffer, m_attributes.endpointGuid.entityId, readerId,
+        change.sequenceNumber, FragmentNumber_t{numFragments}, m_hbFragCount);
+  }
+  flush();
+  return bytesSent;
+}
+
+uint32_t rtps::Writer::getDataPacketSize(DataSize_t payloadSize) {
+  return Header::getRawSize() + SubmessageHeader::getRawSize() +
+         sizeof(Time_t) + SubmessageData::getRawSize() + payloadSize;
+}
+
 bool rtps::Writer::isInitialized() { return m_is_initialized_; }
 
 void rtps::Writer::setSEDPSequenceNumber(const SequenceNumber_t &sn) {
@@ -41,9 +41,10 @@ void MessageReceiver::resetState() {
   haveTimeStamp = false;
 }
 
-bool MessageReceiver::processMessage(const uint8_t *data, DataSize_t size) {
+bool MessageReceiver::processMessage(const uint8_t *data, DataSize_t size,
+                                     pbuf *buffer) {
   resetState();
-  MessageProcessingInfo msgInfo(data, size);
+  MessageProcessingInfo msgInfo(data, size, buffer);
 
   if (!processHeader(msgInfo)) {
     return false;
@@ -108,6 +109,18 @@ bool MessageReceiver::processSubmessage(MessageProcessingInfo &msgInfo,
     RECV_LOG("Processing GAP submessage\n");
     success = processGapSubmessage(msgInfo);
     break;
+  case SubmessageKind::DATA_FRAG:
+    RECV_LOG("Processing DataFrag submessage\n");
+    success = processDataFragSubmessage(msgInfo, submsgHeader);
+    break;
+  case SubmessageKind::NACK_FRAG:
+    RECV_LOG("Processing NackFrag submessage\n");
+    success = processNackFragSubmessage(msgInfo);
+    break;
+  case SubmessageKind::HEARTBEAT_FRAG:
+    RECV_LOG("Processing HeartbeatFrag submessage\n");
+    success = processHeartbeatFragSubmessage(msgInfo);
+    break;
   case SubmessageKind::INFO_TS:
     RECV_LOG("Info_TS submessage not relevant.\n");
     success = true; // Not relevant now
@@ -165,7 +178,8 @@ bool MessageReceiver::processDataSubmessage(
   if (reader != nullptr) {
     Guid_t writerGuid{sourceGuidPrefix, dataSubmsg.writerId};
     ReaderCacheChange change{ChangeKind_t::ALIVE, writerGuid,
-                             dataSubmsg.writerSN, serializedData, size};
+                             dataSubmsg.writerSN, serializedData, size,
+                             msgInfo.buffer};
     reader->newChange(change);
   } else {
 #if RECV_VERBOSE && RTPS_GLOBAL_VERBOSE
@@ -224,4 +238,77 @@ bool MessageReceiver::processGapSubmessage(MessageProcessingInfo &msgInfo) {
     return false;
   }
 }
+bool MessageReceiver::processDataFragSubmessage(
+    MessageProcessingInfo &msgInfo, const SubmessageHeader &submsgHeader) {
+  SubmessageDataFrag submsgFrag;
+  if (!deserializeMessage(msgInfo, submsgFrag)) {
+    return false;
+  }
+
+  // Inline QoS is not supported for fragmented samples
+  const uint16_t payloadOffset = SubmessageHeader::getRawSize() + 4 +
+                                 submsgFrag.octetsToInlineQos;
+  const uint16_t submsgEnd =
+      SubmessageHeader::getRawSize() + submsgHeader.octetsToNextHeader;
+  if (payloadOffset > submsgEnd ||
+      (submsgHeader.flags & FLAG_INLINE_QOS) != 0) {
+    return false;
+  }
+  const uint8_t *serializedData =
+      msgInfo.getPointerToCurrentPos() + payloadOffset;
+  const DataSize_t size = submsgEnd - payloadOffset;
+
+  Reader *reader;
+  if (submsgFrag.readerId == ENTITYID_UNKNOWN) {
+    reader = mp_part->getReaderByWriterId(
+        Guid_t{sourceGuidPrefix, submsgFrag.writerId});
+  } else {
+    reader = mp_part->getReader(submsgFrag.readerId);
+  }
+  if (reader == nullptr) {
+    RECV_LOG("Couldn't find a reader for fragment");
+    return true;
+  }
+
+  reader->newFragments(submsgFrag, sourceGuidPrefix, serializedData, size);
+  return true;
+}
+
+bool MessageReceiver::processNackFragSubmessage(
+    MessageProcessingInfo &msgInfo) {
+  SubmessageNackFrag submsgNackFrag;
+  if (!deserializeMessage(msgInfo, submsgNackFrag)) {
+    return false;
+  }
+
+  Writer *writer = mp_part->getWriter(submsgNackFrag.writerId);
+  if (writer != nullptr) {
+    writer->onNewNackFrag(submsgNackFrag, sourceGuidPrefix);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool MessageReceiver::processHeartbeatFragSubmessage(
+    MessageProcessingInfo &msgInfo) {
+  SubmessageHeartbeatFrag submsgHBFrag;
+  if (!deserializeMessage(msgInfo, submsgHBFrag)) {
+    return false;
+  }
+
+  Reader *reader;
+  if (submsgHBFrag.readerId == ENTITYID_UNKNOWN) {
+    reader = mp_part->getReaderByWriterId(
+        Guid_t{sourceGuidPrefix, submsgHBFrag.writerId});
+  } else {
+    reader = mp_part->getReader(submsgHBFrag.readerId);
+  }
+  if (reader != nullptr) {
+    reader->onNewHeartbeatFrag(submsgHBFrag, sourceGuidPrefix);
+    return true;
+  } else {
+    return false;
+  }
+}
 #undef RECV_VERBOSE
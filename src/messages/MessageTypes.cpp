@@ -128,6 +128,9 @@ void rtps::deserializeSNS(const uint8_t *&position, SequenceNumberSet &set,
                   sizeof(uint32_t));
 
   // Ensure that we copy not more bits than our sequence number set can hold
+  if (set.numBits > SNS_MAX_NUM_BITS) {
+    set.numBits = SNS_MAX_NUM_BITS;
+  }
   if (set.numBits != 0) {
     // equal to size = std::min(SNS_NUM_BYTES, num_bitfields)
     size_t size = num_bitfields > SNS_NUM_BYTES ? SNS_NUM_BYTES : num_bitfields;
@@ -195,9 +198,140 @@ bool rtps::deserializeMessage(const MessageProcessingInfo &info,
   doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.gapStart.low), currentPos,
                   sizeof(msg.gapStart.low));
 
+  if (msg.header.octetsToNextHeader <
+      SubmessageGap::getRawSizeWithSingleElementSNSet() -
+          SubmessageHeader::getRawSize()) {
+    return false;
+  }
   size_t num_bitfields = msg.header.octetsToNextHeader - 4 - 4 - 8 - 8 - 4;
-      remainingSizeAtBeginning - (currentPos - info.getPointerToCurrentPos());
   deserializeSNS(currentPos, msg.gapList, num_bitfields);
 
   return true;
 }
+
+bool rtps::deserializeMessage(const MessageProcessingInfo &info,
+                              SubmessageDataFrag &msg) {
+  if (info.getRemainingSize() < SubmessageDataFrag::getRawSize()) {
+    return false;
+  }
+  if (!deserializeMessage(info, msg.header)) {
+    return false;
+  }
+
+  // Check for length including data
+  if (info.getRemainingSize() <
+          SubmessageHeader::getRawSize() + msg.header.octetsToNextHeader ||
+      msg.header.octetsToNextHeader <
+          SubmessageDataFrag::getRawSize() - SubmessageHeader::getRawSize()) {
+    return false;
+  }
+
+  const uint8_t *currentPos =
+      info.getPointerToCurrentPos() + SubmessageHeader::getRawSize();
+
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.extraFlags), currentPos,
+                  sizeof(uint16_t));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.octetsToInlineQos),
+                  currentPos, sizeof(uint16_t));
+  doCopyAndMoveOn(msg.readerId.entityKey.data(), currentPos,
+                  msg.readerId.entityKey.size());
+  msg.readerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
+  doCopyAndMoveOn(msg.writerId.entityKey.data(), currentPos,
+                  msg.writerId.entityKey.size());
+  msg.writerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.high), currentPos,
+                  sizeof(msg.writerSN.high));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.low), currentPos,
+                  sizeof(msg.writerSN.low));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.fragmentStartingNum.value),
+                  currentPos, sizeof(msg.fragmentStartingNum.value));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.fragmentsInSubmessage),
+                  currentPos, sizeof(uint16_t));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.fragmentSize), currentPos,
+                  sizeof(uint16_t));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.sampleSize), currentPos,
+                  sizeof(uint32_t));
+  return true;
+}
+
+bool rtps::deserializeMessage(const MessageProcessingInfo &info,
+                              SubmessageNackFrag &msg) {
+  if (info.getRemainingSize() < SubmessageNackFrag::getRawSizeWithoutFNSet()) {
+    return false;
+  }
+  if (!deserializeMessage(info, msg.header)) {
+    return false;
+  }
+
+  const uint16_t minLength = SubmessageNackFrag::getRawSizeWithoutFNSet() +
+                             sizeof(FragmentNumber_t) + sizeof(uint32_t) -
+                             SubmessageHeader::getRawSize();
+  if (msg.header.octetsToNextHeader < minLength ||
+      info.getRemainingSize() <
+          SubmessageHeader::getRawSize() + msg.header.octetsToNextHeader) {
+    return false;
+  }
+
+  const uint8_t *currentPos =
+      info.getPointerToCurrentPos() + SubmessageHeader::getRawSize();
+
+  doCopyAndMoveOn(msg.readerId.entityKey.data(), currentPos,
+                  msg.readerId.entityKey.size());
+  msg.readerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
+  doCopyAndMoveOn(msg.writerId.entityKey.data(), currentPos,
+                  msg.writerId.entityKey.size());
+  msg.writerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.high), currentPos,
+                  sizeof(msg.writerSN.high));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.low), currentPos,
+                  sizeof(msg.writerSN.low));
+
+  FragmentNumberSet &set = msg.fragmentNumberState;
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&set.base.value), currentPos,
+                  sizeof(set.base.value));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&set.numBits), currentPos,
+                  sizeof(uint32_t));
+  const size_t numBytes = msg.header.octetsToNextHeader - minLength;
+  if (set.numBits > FNS_MAX_NUM_BITS) {
+    set.numBits = FNS_MAX_NUM_BITS;
+  }
+  const size_t copied =
+      numBytes < 4 * set.getNumWords() ? numBytes : 4 * set.getNumWords();
+  set.bitMap.fill(0);
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(set.bitMap.data()), currentPos,
+                  copied);
+  currentPos += numBytes - copied;
+
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.count.value), currentPos,
+                  sizeof(msg.count.value));
+  return true;
+}
+
+bool rtps::deserializeMessage(const MessageProcessingInfo &info,
+                              SubmessageHeartbeatFrag &msg) {
+  if (info.getRemainingSize() < SubmessageHeartbeatFrag::getRawSize()) {
+    return false;
+  }
+  if (!deserializeMessage(info, msg.header)) {
+    return false;
+  }
+
+  const uint8_t *currentPos =
+      info.getPointerToCurrentPos() + SubmessageHeader::getRawSize();
+
+  doCopyAndMoveOn(msg.readerId.entityKey.data(), currentPos,
+                  msg.readerId.entityKey.size());
+  msg.readerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
+  doCopyAndMoveOn(msg.writerId.entityKey.data(), currentPos,
+                  msg.writerId.entityKey.size());
+  msg.writerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.high), currentPos,
+                  sizeof(msg.writerSN.high));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.low), currentPos,
+                  sizeof(msg.writerSN.low));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.lastFragmentNum.value),
+                  currentPos, sizeof(msg.lastFragmentNum.value));
+  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.count.value), currentPos,
+                  sizeof(msg.count.value));
+  return true;
+}
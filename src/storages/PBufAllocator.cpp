@@ -0,0 +1,90 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/storages/PBufAllocator.h"
+
+#include "rtps/config.h"
+#include "rtps/storages/PBufSlab.h"
+#include "rtps/utils/Diagnostics.h"
+
+using rtps::PBufPool;
+
+namespace {
+
+template <uint8_t NUM_SMALL, uint8_t NUM_LARGE> struct SlabPair {
+  rtps::PBufSlab<rtps::Config::PBUF_SLAB_SMALL_ELEMENT_SIZE, NUM_SMALL> small;
+  rtps::PBufSlab<rtps::Config::PBUF_SLAB_LARGE_ELEMENT_SIZE, NUM_LARGE> large;
+
+  pbuf *allocate(uint16_t length) {
+    // Small requests may use a large element, but never the other way round
+    pbuf *result = small.allocate(length);
+    if (result == nullptr) {
+      result = large.allocate(length);
+    }
+    return result;
+  }
+
+  uint8_t getMaxEverInUse() const {
+    return small.getMaxEverInUse() + large.getMaxEverInUse();
+  }
+};
+
+SlabPair<rtps::Config::PBUF_SLAB_USER_TX_SMALL,
+         rtps::Config::PBUF_SLAB_USER_TX_LARGE>
+    userTxSlabs;
+SlabPair<rtps::Config::PBUF_SLAB_META_TX_SMALL,
+         rtps::Config::PBUF_SLAB_META_TX_LARGE>
+    metaTxSlabs;
+SlabPair<rtps::Config::PBUF_SLAB_HISTORY_SMALL,
+         rtps::Config::PBUF_SLAB_HISTORY_LARGE>
+    historySlabs;
+
+} // namespace
+
+pbuf *rtps::PBufAllocator::allocate(PBufPool pool, uint16_t length) {
+  pbuf *result = nullptr;
+  switch (pool) {
+  case PBufPool::USER_TX:
+    result = userTxSlabs.allocate(length);
+    break;
+  case PBufPool::META_TX:
+    result = metaTxSlabs.allocate(length);
+    break;
+  case PBufPool::HISTORY:
+    result = historySlabs.allocate(length);
+    break;
+  case PBufPool::LWIP:
+    break;
+  }
+
+  if (result == nullptr && pool != PBufPool::LWIP) {
+    Diagnostics::Network::slab_fallback_allocations++;
+  }
+  if (result == nullptr) {
+    result = pbuf_alloc(PBUF_TRANSPORT, length, PBUF_POOL);
+  }
+  if (result == nullptr) {
+    Diagnostics::Network::lwip_allocation_failures++;
+  }
+  return result;
+}
+
+uint8_t rtps::PBufAllocator::getMaxEverInUse(PBufPool pool) {
+  switch (pool) {
+  case PBufPool::USER_TX:
+    return userTxSlabs.getMaxEverInUse();
+  case PBufPool::META_TX:
+    return metaTxSlabs.getMaxEverInUse();
+  case PBufPool::HISTORY:
+    return historySlabs.getMaxEverInUse();
+  case PBufPool::LWIP:
+    break;
+  }
+  return 0;
+}
@@ -31,8 +31,8 @@ PBufWrapper::PBufWrapper(pbuf *bufferToWrap) : firstElement(bufferToWrap) {
   m_freeSpace = 0; // Assume it to be full
 }
 
-PBufWrapper::PBufWrapper(DataSize_t length)
-    : firstElement(pbuf_alloc(m_layer, length, m_type)) {
+PBufWrapper::PBufWrapper(DataSize_t length, PBufPool pool)
+    : firstElement(PBufAllocator::allocate(pool, length)), m_pool(pool) {
 
   if (isValid()) {
     m_freeSpace = length;
@@ -56,6 +56,7 @@ PBufWrapper &PBufWrapper::operator=(PBufWrapper &&other) noexcept {
 
 void PBufWrapper::copySimpleMembersAndResetBuffer(const PBufWrapper &other) {
   m_freeSpace = other.m_freeSpace;
+  m_pool = other.m_pool;
 
   if (firstElement != nullptr) {
     pbuf_free(firstElement);
@@ -113,6 +114,38 @@ void PBufWrapper::append(const PBufWrapper &other) {
   pbuf_chain(this->firstElement, other.firstElement);
 }
 
+bool PBufWrapper::appendCopy(const PBufWrapper &other) {
+  return appendCopy(other, 0, other.spaceUsed());
+}
+
+bool PBufWrapper::appendCopy(const PBufWrapper &other, DataSize_t offset,
+                             DataSize_t length) {
+  if (static_cast<uint32_t>(offset) + length > other.spaceUsed()) {
+    return false;
+  }
+  if (!reserve(length)) {
+    return false;
+  }
+
+  DataSize_t remaining = length;
+  for (const pbuf *current = other.firstElement;
+       current != nullptr && remaining != 0; current = current->next) {
+    if (offset >= current->len) {
+      offset -= current->len;
+      continue;
+    }
+    const DataSize_t available = current->len - offset;
+    const DataSize_t chunk = remaining < available ? remaining : available;
+    if (!append(static_cast<const uint8_t *>(current->payload) + offset,
+                chunk)) {
+      return false;
+    }
+    offset = 0;
+    remaining -= chunk;
+  }
+  return true;
+}
+
 bool PBufWrapper::reserve(DataSize_t length) {
   int16_t additionalAllocation = length - m_freeSpace;
   if (additionalAllocation <= 0) {
@@ -122,6 +155,8 @@ bool PBufWrapper::reserve(DataSize_t length) {
   return increaseSizeBy(additionalAllocation);
 }
 
+void PBufWrapper::setPool(PBufPool pool) { m_pool = pool; }
+
 void PBufWrapper::reset() {
   if (firstElement != nullptr) {
     m_freeSpace = firstElement->tot_len;
@@ -129,7 +164,7 @@ void PBufWrapper::reset() {
 }
 
 bool PBufWrapper::increaseSizeBy(uint16_t length) {
-  pbuf *allocation = pbuf_alloc(m_layer, length, m_type);
+  pbuf *allocation = PBufAllocator::allocate(m_pool, length);
   if (allocation == nullptr) {
     return false;
   }
@@ -0,0 +1,116 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/storages/SampleHandle.h"
+
+#include "rtps/config.h"
+#include "rtps/utils/Diagnostics.h"
+
+#include <atomic>
+
+using rtps::SampleHandle;
+
+namespace {
+// Each handle holds its own reference, so copies count separately
+std::atomic<uint16_t> numRetained{0};
+} // namespace
+
+SampleHandle::SampleHandle(ChangeKind_t kind, const Guid_t &writerGuid,
+                           const SequenceNumber_t &sn, pbuf *buffer,
+                           const uint8_t *data, DataSize_t size)
+    : kind(kind), writerGuid(writerGuid), sn(sn) {
+  if (buffer == nullptr) {
+    return;
+  }
+  const auto *payload = static_cast<const uint8_t *>(buffer->payload);
+  if (data < payload || data + size > payload + buffer->len) {
+    // Only contiguous views into the first element are supported
+    return;
+  }
+  acquire(buffer);
+  if (isValid()) {
+    m_offset = static_cast<uint16_t>(data - payload);
+    m_size = size;
+  }
+}
+
+SampleHandle::~SampleHandle() { reset(); }
+
+SampleHandle::SampleHandle(const SampleHandle &other)
+    : kind(other.kind), writerGuid(other.writerGuid), sn(other.sn) {
+  acquire(other.m_buffer);
+  if (isValid()) {
+    m_offset = other.m_offset;
+    m_size = other.m_size;
+  }
+}
+
+SampleHandle::SampleHandle(SampleHandle &&other) noexcept
+    : kind(other.kind), writerGuid(other.writerGuid), sn(other.sn),
+      m_buffer(other.m_buffer), m_offset(other.m_offset),
+      m_size(other.m_size) {
+  other.m_buffer = nullptr;
+  other.m_size = 0;
+}
+
+SampleHandle &SampleHandle::operator=(const SampleHandle &other) {
+  if (this != &other) {
+    *this = SampleHandle{other};
+  }
+  return *this;
+}
+
+SampleHandle &SampleHandle::operator=(SampleHandle &&other) noexcept {
+  if (this != &other) {
+    reset();
+    kind = other.kind;
+    writerGuid = other.writerGuid;
+    sn = other.sn;
+    m_buffer = other.m_buffer;
+    m_offset = other.m_offset;
+    m_size = other.m_size;
+    other.m_buffer = nullptr;
+    other.m_size = 0;
+  }
+  return *this;
+}
+
+const uint8_t *SampleHandle::getData() const {
+  if (!isValid()) {
+    return nullptr;
+  }
+  return static_cast<const uint8_t *>(m_buffer->payload) + m_offset;
+}
+
+void SampleHandle::reset() {
+  if (m_buffer == nullptr) {
+    return;
+  }
+  pbuf_free(m_buffer);
+  m_buffer = nullptr;
+  m_size = 0;
+  --numRetained;
+}
+
+uint16_t SampleHandle::getNumRetainedBuffers() { return numRetained; }
+
+void SampleHandle::acquire(pbuf *buffer) {
+  if (buffer == nullptr) {
+    return;
+  }
+  uint16_t current = numRetained;
+  do {
+    if (current >= Config::MAX_RETAINED_SAMPLES) {
+      Diagnostics::Network::retained_samples_rejected++;
+      return;
+    }
+  } while (!numRetained.compare_exchange_weak(current, current + 1));
+  pbuf_ref(buffer);
+  m_buffer = buffer;
+}
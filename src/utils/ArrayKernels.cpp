@@ -0,0 +1,149 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/utils/ArrayKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Scalar fallback and tail handling. Plain loops over fixed sized words, so
+// compilers for targets without the intrinsics below can still vectorize.
+void swapScalar16(uint8_t *dst, const uint8_t *src, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    uint16_t word;
+    memcpy(&word, src + i * sizeof(word), sizeof(word));
+    word = __builtin_bswap16(word);
+    memcpy(dst + i * sizeof(word), &word, sizeof(word));
+  }
+}
+
+void swapScalar32(uint8_t *dst, const uint8_t *src, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t word;
+    memcpy(&word, src + i * sizeof(word), sizeof(word));
+    word = __builtin_bswap32(word);
+    memcpy(dst + i * sizeof(word), &word, sizeof(word));
+  }
+}
+
+void swapScalar64(uint8_t *dst, const uint8_t *src, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t word;
+    memcpy(&word, src + i * sizeof(word), sizeof(word));
+    word = __builtin_bswap64(word);
+    memcpy(dst + i * sizeof(word), &word, sizeof(word));
+  }
+}
+
+#if defined(__AVX2__)
+constexpr size_t VECTOR_SIZE = 32;
+
+template <size_t WORD_SIZE> __m256i getShuffleMask() {
+  alignas(32) uint8_t mask[VECTOR_SIZE];
+  for (size_t i = 0; i < VECTOR_SIZE; ++i) {
+    // Byte shuffles work per 128 bit lane, indices are relative to it
+    const size_t inLane = i % 16;
+    mask[i] = static_cast<uint8_t>(inLane - inLane % WORD_SIZE +
+                                   (WORD_SIZE - 1 - inLane % WORD_SIZE));
+  }
+  return _mm256_load_si256(reinterpret_cast<const __m256i *>(mask));
+}
+
+template <size_t WORD_SIZE>
+size_t swapVector(uint8_t *dst, const uint8_t *src, size_t count) {
+  const __m256i mask = getShuffleMask<WORD_SIZE>();
+  const size_t numVectors = count * WORD_SIZE / VECTOR_SIZE;
+  for (size_t i = 0; i < numVectors; ++i) {
+    const __m256i value = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(src + i * VECTOR_SIZE));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * VECTOR_SIZE),
+                        _mm256_shuffle_epi8(value, mask));
+  }
+  return numVectors * VECTOR_SIZE / WORD_SIZE;
+}
+#elif defined(__SSE2__)
+constexpr size_t VECTOR_SIZE = 16;
+
+// SSE2 has no byte shuffle. Bytes are swapped within 16 bit words by
+// shifting, larger words by reordering their 16 bit words first.
+inline __m128i swapWithinWords16(__m128i value) {
+  return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+template <size_t WORD_SIZE> __m128i swapVectorWords(__m128i value);
+
+template <> inline __m128i swapVectorWords<2>(__m128i value) {
+  return swapWithinWords16(value);
+}
+
+template <> inline __m128i swapVectorWords<4>(__m128i value) {
+  value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+  value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+  return swapWithinWords16(value);
+}
+
+template <> inline __m128i swapVectorWords<8>(__m128i value) {
+  value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+  value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+  return swapWithinWords16(value);
+}
+
+template <size_t WORD_SIZE>
+size_t swapVector(uint8_t *dst, const uint8_t *src, size_t count) {
+  const size_t numVectors = count * WORD_SIZE / VECTOR_SIZE;
+  for (size_t i = 0; i < numVectors; ++i) {
+    const __m128i value = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(src + i * VECTOR_SIZE));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * VECTOR_SIZE),
+                     swapVectorWords<WORD_SIZE>(value));
+  }
+  return numVectors * VECTOR_SIZE / WORD_SIZE;
+}
+#else
+template <size_t WORD_SIZE>
+size_t swapVector(uint8_t * /*dst*/, const uint8_t * /*src*/,
+                  size_t /*count*/) {
+  return 0;
+}
+#endif
+
+} // namespace
+
+void rtps::ArrayKernels::copySwapped(void *dst, const void *src, size_t count,
+                                     size_t wordSize) {
+  auto *dstBytes = static_cast<uint8_t *>(dst);
+  const auto *srcBytes = static_cast<const uint8_t *>(src);
+  size_t done = 0;
+  switch (wordSize) {
+  case 1:
+    if (dst != src) {
+      memcpy(dst, src, count);
+    }
+    break;
+  case 2:
+    done = swapVector<2>(dstBytes, srcBytes, count);
+    swapScalar16(dstBytes + done * 2, srcBytes + done * 2, count - done);
+    break;
+  case 4:
+    done = swapVector<4>(dstBytes, srcBytes, count);
+    swapScalar32(dstBytes + done * 4, srcBytes + done * 4, count - done);
+    break;
+  case 8:
+    done = swapVector<8>(dstBytes, srcBytes, count);
+    swapScalar64(dstBytes + done * 8, srcBytes + done * 8, count - done);
+    break;
+  default:
+    break;
+  }
+}
@@ -35,10 +35,51 @@ uint32_t max_ever_elements_incoming_metatraffic_queue;
 namespace StatefulReader {
 uint32_t sfr_unexpected_sn;
 uint32_t sfr_retransmit_requests;
+uint32_t sfr_buffered_out_of_order;
+uint32_t sfr_reorder_buffer_overflows;
+uint32_t sfr_acknacks_merged;
+uint32_t sfr_acknack_messages_sent;
+uint32_t sfr_delta_samples_dropped;
 } // namespace StatefulReader
 
+namespace StatefulWriter {
+uint32_t sfw_data_bytes_sent;
+uint32_t sfw_repair_bytes_sent;
+uint32_t sfw_nacks_merged;
+uint32_t sfw_multicast_repairs;
+uint32_t sfw_conflated_samples;
+uint32_t sfw_delta_samples;
+uint32_t sfw_key_frames;
+uint32_t sfw_delta_bytes_saved;
+} // namespace StatefulWriter
+
+namespace StatelessWriter {
+uint32_t slw_conflated_samples;
+} // namespace StatelessWriter
+
+namespace Compression {
+uint32_t compressed_samples;
+uint32_t compression_bytes_saved;
+uint32_t compression_time_us;
+uint32_t decompressed_samples;
+uint32_t decompression_time_us;
+uint32_t decompression_failures;
+} // namespace Compression
+
+namespace FlowControl {
+uint32_t paced_transmissions;
+uint32_t pacing_delay_ms;
+} // namespace FlowControl
+
 namespace Network {
 uint32_t lwip_allocation_failures;
+uint32_t aggregated_submessages;
+uint32_t retained_samples_rejected;
+uint32_t slab_fallback_allocations;
+uint32_t fragmented_samples_dropped;
+uint32_t unaligned_plain_samples;
+uint32_t intra_process_samples;
+uint32_t udp_local_bypass_packets;
 }
 
 namespace SEDP {
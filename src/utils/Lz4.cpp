@@ -0,0 +1,204 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/utils/Lz4.h"
+
+#include "rtps/config.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t MIN_MATCH = 4;
+// The format requires the last bytes of a block to be literals and the last
+// match to start MF_LIMIT bytes before the end at the latest
+constexpr uint32_t LAST_LITERALS = 5;
+constexpr uint32_t MF_LIMIT = 12;
+constexpr uint32_t MAX_OFFSET = 0xFFFF;
+constexpr uint32_t MAX_INPUT_SIZE = 0x10000;
+constexpr uint8_t TOKEN_MAX_LENGTH = 15;
+
+uint32_t read32(const uint8_t *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >>
+         (32 - rtps::Config::COMPRESSION_HASH_BITS);
+}
+
+// Lengths that do not fit into the token continue in bytes of up to 255
+bool writeLength(uint8_t *&op, const uint8_t *oend, uint32_t length) {
+  for (; length >= 255; length -= 255) {
+    if (op == oend) {
+      return false;
+    }
+    *op++ = 255;
+  }
+  if (op == oend) {
+    return false;
+  }
+  *op++ = static_cast<uint8_t>(length);
+  return true;
+}
+
+// A matchLength of 0 writes the last sequence, which has literals only
+bool writeSequence(uint8_t *&op, const uint8_t *oend, const uint8_t *literals,
+                   uint32_t numLiterals, uint32_t offset,
+                   uint32_t matchLength) {
+  if (op == oend) {
+    return false;
+  }
+  uint8_t *token = op++;
+  if (numLiterals >= TOKEN_MAX_LENGTH) {
+    *token = TOKEN_MAX_LENGTH << 4;
+    if (!writeLength(op, oend, numLiterals - TOKEN_MAX_LENGTH)) {
+      return false;
+    }
+  } else {
+    *token = static_cast<uint8_t>(numLiterals << 4);
+  }
+  if (static_cast<uint32_t>(oend - op) < numLiterals) {
+    return false;
+  }
+  memcpy(op, literals, numLiterals);
+  op += numLiterals;
+
+  if (matchLength == 0) {
+    return true;
+  }
+  if (oend - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<uint8_t>(offset & 0xFF);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  const uint32_t extra = matchLength - MIN_MATCH;
+  if (extra >= TOKEN_MAX_LENGTH) {
+    *token |= TOKEN_MAX_LENGTH;
+    return writeLength(op, oend, extra - TOKEN_MAX_LENGTH);
+  }
+  *token |= static_cast<uint8_t>(extra);
+  return true;
+}
+
+bool readLength(const uint8_t *src, uint32_t srcSize, uint32_t &ip,
+                uint32_t &length) {
+  uint8_t next;
+  do {
+    if (ip == srcSize) {
+      return false;
+    }
+    next = src[ip++];
+    length += next;
+  } while (next == 255);
+  return true;
+}
+
+} // namespace
+
+uint32_t rtps::Lz4::compress(const uint8_t *src, uint32_t srcSize,
+                             uint8_t *dst, uint32_t dstCapacity) {
+  if (src == nullptr || dst == nullptr || srcSize > MAX_INPUT_SIZE) {
+    return 0;
+  }
+
+  uint8_t *op = dst;
+  const uint8_t *oend = dst + dstCapacity;
+  uint32_t anchor = 0;
+  if (srcSize > MF_LIMIT) {
+    // Positions fit into 16 bit, inputs are limited to 64 KiB
+    uint16_t table[1 << Config::COMPRESSION_HASH_BITS] = {};
+    const uint32_t matchLimit = srcSize - LAST_LITERALS;
+    const uint32_t ipLimit = srcSize - MF_LIMIT;
+    uint32_t ip = 1;
+    while (ip <= ipLimit) {
+      const uint32_t h = hash(read32(src + ip));
+      uint32_t ref = table[h];
+      table[h] = static_cast<uint16_t>(ip);
+      if (ip - ref > MAX_OFFSET || read32(src + ref) != read32(src + ip)) {
+        ++ip;
+        continue;
+      }
+
+      while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+        --ip;
+        --ref;
+      }
+      uint32_t length = MIN_MATCH;
+      while (ip + length < matchLimit &&
+             src[ref + length] == src[ip + length]) {
+        ++length;
+      }
+      if (!writeSequence(op, oend, src + anchor, ip - anchor, ip - ref,
+                         length)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+    }
+  }
+
+  if (!writeSequence(op, oend, src + anchor, srcSize - anchor, 0, 0)) {
+    return 0;
+  }
+  return static_cast<uint32_t>(op - dst);
+}
+
+uint32_t rtps::Lz4::decompress(const uint8_t *src, uint32_t srcSize,
+                               uint8_t *dst, uint32_t dstCapacity) {
+  if (src == nullptr || dst == nullptr) {
+    return 0;
+  }
+
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  while (ip < srcSize) {
+    const uint8_t token = src[ip++];
+    uint32_t numLiterals = token >> 4;
+    if (numLiterals == TOKEN_MAX_LENGTH &&
+        !readLength(src, srcSize, ip, numLiterals)) {
+      return 0;
+    }
+    if (srcSize - ip < numLiterals || dstCapacity - op < numLiterals) {
+      return 0;
+    }
+    memcpy(dst + op, src + ip, numLiterals);
+    ip += numLiterals;
+    op += numLiterals;
+    if (ip == srcSize) {
+      return op;
+    }
+
+    if (srcSize - ip < 2) {
+      return 0;
+    }
+    const uint32_t offset = src[ip] | (src[ip + 1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op) {
+      return 0;
+    }
+    uint32_t length = token & TOKEN_MAX_LENGTH;
+    if (length == TOKEN_MAX_LENGTH && !readLength(src, srcSize, ip, length)) {
+      return 0;
+    }
+    length += MIN_MATCH;
+    if (dstCapacity - op < length) {
+      return 0;
+    }
+    // Byte by byte, source and destination overlap for repeating patterns
+    for (uint32_t i = 0; i < length; ++i) {
+      dst[op + i] = dst[op + i - offset];
+    }
+    op += length;
+  }
+  // Every block ends with a literal-only sequence
+  return 0;
+}
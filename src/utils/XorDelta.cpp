@@ -0,0 +1,85 @@
+/**
+ * Copyright © 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+ *
+ * This file is part of embeddedRTPS.
+ *
+ * You should have received a copy of the MIT License along with embeddedRTPS.
+ * If not, see <https://mit-license.org>.
+ */
+
+#include "rtps/utils/XorDelta.h"
+
+#include <cstring>
+
+namespace {
+// Both lengths of a run are stored in one byte each
+constexpr uint32_t MAX_RUN_LENGTH = 255;
+} // namespace
+
+bool rtps::XorDelta::encode(const uint8_t *base, const uint8_t *current,
+                            uint32_t size, uint8_t *dst, uint32_t dstCapacity,
+                            uint32_t &encodedSize) {
+  if (base == nullptr || current == nullptr || dst == nullptr) {
+    return false;
+  }
+
+  // The decoder takes everything behind the last change from the base
+  uint32_t end = size;
+  while (end > 0 && base[end - 1] == current[end - 1]) {
+    --end;
+  }
+
+  uint32_t op = 0;
+  uint32_t ip = 0;
+  while (ip < end) {
+    uint32_t skip = 0;
+    while (skip < MAX_RUN_LENGTH && base[ip] == current[ip]) {
+      ++skip;
+      ++ip;
+    }
+
+    const uint32_t start = ip;
+    while (ip < end && ip - start < MAX_RUN_LENGTH &&
+           base[ip] != current[ip]) {
+      ++ip;
+    }
+    const uint32_t count = ip - start;
+    if (dstCapacity - op < 2 + count) {
+      return false;
+    }
+    dst[op++] = static_cast<uint8_t>(skip);
+    dst[op++] = static_cast<uint8_t>(count);
+    for (uint32_t i = start; i < ip; ++i) {
+      dst[op++] = base[i] ^ current[i];
+    }
+  }
+  encodedSize = op;
+  return true;
+}
+
+bool rtps::XorDelta::decode(const uint8_t *base, const uint8_t *delta,
+                            uint32_t deltaSize, uint8_t *dst, uint32_t size) {
+  if (base == nullptr || delta == nullptr || dst == nullptr) {
+    return false;
+  }
+
+  memcpy(dst, base, size);
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  while (ip < deltaSize) {
+    if (deltaSize - ip < 2) {
+      return false;
+    }
+    const uint32_t skip = delta[ip++];
+    const uint32_t count = delta[ip++];
+    if (size - op < skip || size - op - skip < count ||
+        deltaSize - ip < count) {
+      return false;
+    }
+    op += skip;
+    for (uint32_t i = 0; i < count; ++i) {
+      dst[op++] ^= delta[ip++];
+    }
+  }
+  return true;
+}